@@ -0,0 +1,132 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#include "../include/http/http_message.h"
+#include "../include/http/http_server.h"
+
+using httpserver::HttpMethod;
+using httpserver::HttpRequest;
+using httpserver::HttpResponse;
+using httpserver::HttpServer;
+using httpserver::HttpStatusCode;
+
+// Every heap allocation in the process goes through these
+std::atomic<std::uint64_t> gAllocations{0};
+
+void* operator new(size_t size) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size ? size : 1)) return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+namespace {
+    constexpr std::uint16_t PORT = 18081;
+    constexpr int WARMUP_REQUESTS = 1000;
+    constexpr int REQUESTS = 100000;
+
+    const char kRequest[] =
+        "GET /?user=42&lang=en HTTP/1.1\r\n"
+        "Host: localhost:18081\r\n"
+        "User-Agent: alloc-bench/1.0\r\n"
+        "Accept: */*\r\n"
+        "Accept-Encoding: gzip, deflate\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n";
+
+    // Sends one request and reads until the expected response size has arrived
+    bool RoundTrip(int fd, size_t responseSize) {
+        static char buffer[8192];
+        if (send(fd, kRequest, sizeof(kRequest) - 1, 0) != static_cast<ssize_t>(sizeof(kRequest) - 1)) {
+            return false;
+        }
+        size_t received = 0;
+        while (received < responseSize) {
+            ssize_t count = recv(fd, buffer, sizeof(buffer), 0);
+            if (count <= 0) return false;
+            received += count;
+        }
+        return true;
+    }
+}
+
+int main() {
+    HttpServer server("127.0.0.1", PORT);
+    server.RegisterRequestHandler("/", HttpMethod::GET, [](const HttpRequest& request) {
+        HttpResponse response(HttpStatusCode::OK);
+        response.SetHeader("Content-Type", "text/plain");
+        // Body built directly in the request arena
+        httpserver::ArenaString body(httpserver::ArenaAllocator<char>(request.GetArena()));
+        body.append("hello ");
+        body.append(request.GetURIView().GetQueryParam("user").c_str());
+        body.append("\n");
+        response.SetContent(std::move(body));
+        return response;
+    });
+    server.Start();
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(PORT);
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    for (int attempt = 0; connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0; ++attempt) {
+        if (attempt == 100) {
+            std::perror("connect");
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    // Learn the response size from the first exchange
+    char probe[4096];
+    send(fd, kRequest, sizeof(kRequest) - 1, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ssize_t responseSize = recv(fd, probe, sizeof(probe), 0);
+    if (responseSize <= 0) {
+        std::fprintf(stderr, "no response\n");
+        return 1;
+    }
+
+    for (int i = 0; i < WARMUP_REQUESTS; ++i) {
+        RoundTrip(fd, responseSize);
+    }
+
+    std::uint64_t before = gAllocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < REQUESTS; ++i) {
+        if (!RoundTrip(fd, responseSize)) {
+            std::fprintf(stderr, "request %d failed\n", i);
+            return 1;
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    std::uint64_t allocations = gAllocations.load() - before;
+
+    std::printf("keep-alive GET, %d requests\n", REQUESTS);
+    std::printf("allocations/request: %.3f\n", static_cast<double>(allocations) / REQUESTS);
+    std::printf("us/request:          %.2f\n",
+                std::chrono::duration<double, std::micro>(elapsed).count() / REQUESTS);
+
+    close(fd);
+    server.Stop();
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "../include/http/http_message.h"
+#include "../include/http/http_server.h"
+
+using httpserver::HttpMethod;
+using httpserver::HttpRequest;
+using httpserver::HttpResponse;
+using httpserver::HttpServer;
+using httpserver::HttpStatusCode;
+using httpserver::LoadBalancerConfig;
+using httpserver::PlacementPolicy;
+using httpserver::WorkerLoadStats;
+namespace config = httpserver::config;
+
+namespace {
+    constexpr std::uint16_t BASE_PORT = 18090;
+    constexpr int CONNECTIONS = 2 * config::WORKER_POOL_SIZE;
+    constexpr int HANDLER_SPIN_US = 20;
+    constexpr int COLD_INTERVAL_MS = 20;
+    constexpr auto RUN_TIME = std::chrono::milliseconds(2000);
+
+    const char kRequest[] = "GET /work HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n\r\n";
+
+    int Connect(std::uint16_t port) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+        for (int attempt = 0; connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0; ++attempt) {
+            if (attempt == 100) return -1;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return fd;
+    }
+
+    // The response has a fixed size, so reading until the body's last byte is enough
+    bool RoundTrip(int fd) {
+        char buffer[1024];
+        if (send(fd, kRequest, sizeof(kRequest) - 1, 0) != static_cast<ssize_t>(sizeof(kRequest) - 1)) {
+            return false;
+        }
+        while (true) {
+            ssize_t count = recv(fd, buffer, sizeof(buffer), 0);
+            if (count <= 0) return false;
+            if (buffer[count - 1] == '\n') return true;
+        }
+    }
+
+    // Connections 0 and WORKER_POOL_SIZE are hot, so strict round-robin puts both on worker 0
+    void Run(const char* name, const LoadBalancerConfig& balancing, std::uint16_t port) {
+        HttpServer server("127.0.0.1", port);
+        server.SetLoadBalancing(balancing);
+        server.RegisterRequestHandler("/work", HttpMethod::GET, [](const HttpRequest&) {
+            auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(HANDLER_SPIN_US);
+            while (std::chrono::steady_clock::now() < until) {
+            }
+            HttpResponse response(HttpStatusCode::OK);
+            response.SetContent("done\n");
+            return response;
+        });
+        server.Start();
+
+        // Connect one at a time so accept order matches connection order
+        std::vector<int> fds;
+        for (int i = 0; i < CONNECTIONS; ++i) {
+            int fd = Connect(port);
+            if (fd < 0 || !RoundTrip(fd)) {
+                std::fprintf(stderr, "%s: connection %d failed\n", name, i);
+                return;
+            }
+            fds.push_back(fd);
+        }
+
+        std::uint64_t eventsBefore[config::WORKER_POOL_SIZE];
+        for (int i = 0; i < config::WORKER_POOL_SIZE; ++i) {
+            eventsBefore[i] = server.GetWorkerLoad(i).events;
+        }
+
+        std::atomic<bool> running{true};
+        std::atomic<std::uint64_t> hotRequests{0};
+        std::vector<std::thread> clients;
+        for (int hot : {0, config::WORKER_POOL_SIZE}) {
+            clients.emplace_back([&, hot] {
+                while (running && RoundTrip(fds[hot])) {
+                    hotRequests.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+        clients.emplace_back([&] {
+            while (running) {
+                for (int i = 0; i < CONNECTIONS; ++i) {
+                    if (i % config::WORKER_POOL_SIZE != 0) RoundTrip(fds[i]);
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(COLD_INTERVAL_MS));
+            }
+        });
+
+        std::this_thread::sleep_for(RUN_TIME);
+        double imbalance = server.GetLoadImbalance();
+        running = false;
+        for (std::thread& client : clients) {
+            client.join();
+        }
+
+        std::uint64_t total = 0;
+        std::uint64_t busiest = 0;
+        std::uint64_t migrations = 0;
+        for (int i = 0; i < config::WORKER_POOL_SIZE; ++i) {
+            WorkerLoadStats stats = server.GetWorkerLoad(i);
+            std::uint64_t events = stats.events - eventsBefore[i];
+            total += events;
+            busiest = std::max(busiest, events);
+            migrations += stats.migratedOut;
+        }
+
+        double seconds = std::chrono::duration<double>(RUN_TIME).count();
+        std::printf("%-22s %12.0f %10.2f %14.1f%% %11llu\n", name, hotRequests / seconds, imbalance,
+                    total ? 100.0 * busiest / total : 0.0, static_cast<unsigned long long>(migrations));
+
+        for (int fd : fds) {
+            close(fd);
+        }
+        server.Stop();
+    }
+}
+
+int main() {
+    std::printf("%d connections, 2 hot (closed loop, %dus handler), the rest every %dms\n\n",
+                CONNECTIONS, HANDLER_SPIN_US, COLD_INTERVAL_MS);
+    std::printf("%-22s %12s %10s %15s %11s\n", "placement", "hot req/s", "imbalance", "busiest share", "migrations");
+
+    Run("round-robin", LoadBalancerConfig(PlacementPolicy::RoundRobin), BASE_PORT);
+    Run("least-connections", LoadBalancerConfig(PlacementPolicy::LeastConnections), BASE_PORT + 1);
+    Run("power-of-two", LoadBalancerConfig(PlacementPolicy::PowerOfTwoChoices), BASE_PORT + 2);
+    Run("round-robin+rebalance", LoadBalancerConfig(PlacementPolicy::RoundRobin, true), BASE_PORT + 3);
+    return 0;
+}
\ No newline at end of file
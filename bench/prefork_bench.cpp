@@ -0,0 +1,169 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/http/http_message.h"
+#include "../include/http/http_server.h"
+
+using httpserver::HttpMethod;
+using httpserver::HttpRequest;
+using httpserver::HttpResponse;
+using httpserver::HttpServer;
+using httpserver::HttpStatusCode;
+using httpserver::ProcessStats;
+namespace config = httpserver::config;
+
+namespace {
+    constexpr std::uint16_t BASE_PORT = 18100;
+    constexpr int CLIENT_THREADS = 4;
+    constexpr int CONNECTIONS_PER_THREAD = 64;
+    constexpr auto WARMUP_TIME = std::chrono::milliseconds(500);
+    constexpr auto RUN_TIME = std::chrono::milliseconds(3000);
+
+    // Same request and handler as the wrk scenario in the README
+    const char kRequest[] = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+    int Connect(std::uint16_t port) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 && errno != EINPROGRESS) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    // Closed loop like wrk: every connection sends its next request as soon as the response is in.
+    // The response has a fixed size and ends with the body's newline.
+    void Client(std::uint16_t port, const std::atomic<bool>& running, std::atomic<std::uint64_t>& completed) {
+        int epollFd = epoll_create1(0);
+        std::vector<int> fds;
+        for (int i = 0; i < CONNECTIONS_PER_THREAD; ++i) {
+            int fd = Connect(port);
+            if (fd < 0) continue;
+            epoll_event event;
+            event.events = EPOLLOUT;
+            event.data.fd = fd;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+            fds.push_back(fd);
+        }
+
+        epoll_event events[CONNECTIONS_PER_THREAD];
+        char buffer[1024];
+        std::uint64_t local = 0;
+        while (running) {
+            int count = epoll_wait(epollFd, events, CONNECTIONS_PER_THREAD, 10);
+            for (int i = 0; i < count; ++i) {
+                int fd = events[i].data.fd;
+                epoll_event next;
+                next.data.fd = fd;
+                if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+                    continue;
+                }
+                if (events[i].events & EPOLLIN) {
+                    ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+                    if (received <= 0 || buffer[received - 1] != '\n') continue;
+                    ++local;
+                }
+                send(fd, kRequest, sizeof(kRequest) - 1, MSG_NOSIGNAL);
+                next.events = EPOLLIN;
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &next);
+            }
+            completed.fetch_add(local, std::memory_order_relaxed);
+            local = 0;
+        }
+
+        for (int fd : fds) {
+            close(fd);
+        }
+        close(epollFd);
+    }
+
+    double Measure(std::uint16_t port) {
+        std::atomic<bool> running{true};
+        std::atomic<std::uint64_t> completed{0};
+        std::vector<std::thread> clients;
+        for (int i = 0; i < CLIENT_THREADS; ++i) {
+            clients.emplace_back(Client, port, std::cref(running), std::ref(completed));
+        }
+
+        std::this_thread::sleep_for(WARMUP_TIME);
+        std::uint64_t before = completed.load();
+        std::this_thread::sleep_for(RUN_TIME);
+        std::uint64_t after = completed.load();
+        running = false;
+        for (std::thread& client : clients) {
+            client.join();
+        }
+        return (after - before) / std::chrono::duration<double>(RUN_TIME).count();
+    }
+
+    void RegisterTest(HttpServer& server) {
+        server.RegisterRequestHandler("/", HttpMethod::GET, [](const HttpRequest&) {
+            HttpResponse response(HttpStatusCode::OK);
+            response.SetHeader("Content-Type", "text/plain");
+            response.SetContent("test\n");
+            return response;
+        });
+    }
+
+    void RunThreaded(std::uint16_t port) {
+        HttpServer server("127.0.0.1", port);
+        RegisterTest(server);
+        server.Start();
+        double rate = Measure(port);
+        server.Stop();
+        std::printf("%-10s %10d %14.0f\n", "threaded", config::WORKER_POOL_SIZE, rate);
+    }
+
+    // Forks before any client thread exists, so the workers start from a single-threaded image
+    void RunPrefork(std::uint16_t port, int processes) {
+        HttpServer server("127.0.0.1", port);
+        RegisterTest(server);
+        server.StartPrefork(processes);
+        double rate = Measure(port);
+
+        std::uint64_t busiest = 0;
+        std::uint64_t total = 0;
+        for (const ProcessStats& stats : server.GetProcessStats()) {
+            busiest = std::max(busiest, stats.requests);
+            total += stats.requests;
+        }
+        server.Stop();
+        std::printf("%-10s %10d %14.0f %13.1f%%\n", "prefork", processes, rate,
+                    total ? 100.0 * busiest / total : 0.0);
+    }
+}
+
+int main() {
+    int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::printf("%d connections, keep-alive GET /, %d cores\n\n", CLIENT_THREADS * CONNECTIONS_PER_THREAD, cores);
+    std::printf("%-10s %10s %14s %14s\n", "mode", "loops", "req/s", "busiest share");
+
+    RunThreaded(BASE_PORT);
+    std::vector<int> counts = {1, cores, 2 * cores, config::WORKER_POOL_SIZE};
+    std::sort(counts.begin(), counts.end());
+    counts.erase(std::unique(counts.begin(), counts.end()), counts.end());
+    std::uint16_t port = BASE_PORT + 1;
+    for (int processes : counts) {
+        RunPrefork(port++, processes);
+    }
+    return 0;
+}
\ No newline at end of file
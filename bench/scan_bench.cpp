@@ -0,0 +1,147 @@
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+#include "../include/http/http_message.h"
+#include "../include/utils/scan.h"
+#include "../include/utils/serialize.h"
+
+using httpserver::HttpRequest;
+using namespace httpserver::scan;
+
+namespace {
+    constexpr int FUZZ_ITERATIONS = 200000;
+    constexpr int BENCH_ITERATIONS = 20000;
+    const Isa kIsas[] = {Isa::Scalar, Isa::SSE42, Isa::AVX2};
+    volatile size_t gSink;
+
+#if defined(__x86_64__) || defined(__i386__)
+    const char kCounterUnit[] = "TSC cycle";
+
+    unsigned long long ReadCounter() {
+        return __rdtsc();
+    }
+#else
+    // No portable cycle counter, rates are per nanosecond instead
+    const char kCounterUnit[] = "ns";
+
+    unsigned long long ReadCounter() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+#endif
+
+    std::string MakeRequest(size_t cookieBytes, int extraHeaders) {
+        std::string request = "GET /api/v1/items?page=2 HTTP/1.1\r\nHost: example.com\r\n";
+        request += "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)\r\n";
+        for (int i = 0; i < extraHeaders; ++i) {
+            request += "X-Custom-Header-" + std::to_string(i) + ": value-" + std::to_string(i * 31) + "; q=0.9\r\n";
+        }
+        request += "Cookie: ";
+        for (size_t i = 0; request.length() < cookieBytes + 200; ++i) {
+            request += "session_" + std::to_string(i) + "=a8f3c9e1b7d24f6a9c0e5b3d1f7a2c4e; ";
+        }
+        request += "\r\n\r\n";
+        return request;
+    }
+
+    // Same walk as FromString<HttpRequest> without allocations, isolates the kernels
+    size_t ScanHeaders(const Kernels& kernels, const std::string& request) {
+        const char* pos = request.data();
+        const char* end = pos + request.length();
+        size_t checksum = 0;
+        pos = kernels.findCRLF(pos, end) + 2;
+        while (pos < end) {
+            const char* lineEnd = kernels.findCRLF(pos, end);
+            if (lineEnd == pos || lineEnd == end) break;
+            const char* colon = kernels.findChar(pos, lineEnd, ':');
+            checksum += kernels.findNonToken(pos, colon) - pos;
+            checksum += kernels.findNonFieldValue(colon + 1, lineEnd) - colon;
+            pos = lineEnd + 2;
+        }
+        return checksum;
+    }
+
+    void Fail(const char* kernel, Isa isa, const std::string& input) {
+        std::fprintf(stderr, "%s mismatch (%s) on %zu byte input\n", kernel, GetIsaName(isa), input.length());
+        std::exit(1);
+    }
+
+    // Random buffers biased toward delimiters, compared at every offset against the scalar kernels
+    void Fuzz() {
+        static const char kAlphabet[] = "\r\n:\t azAZ09!~\"(),/;=?@[]{}\x7f\x80\xff\x01";
+        std::mt19937 generator(42);
+        const Kernels& reference = GetKernels(Isa::Scalar);
+
+        for (int iteration = 0; iteration < FUZZ_ITERATIONS; ++iteration) {
+            std::string input(generator() % 200, '\0');
+            int bias = generator() % 4;
+            for (char& c : input) {
+                c = (generator() % 8 < static_cast<unsigned>(bias)) ? 'a' + generator() % 26
+                                                                    : kAlphabet[generator() % (sizeof(kAlphabet) - 1)];
+            }
+            const char* begin = input.data();
+            const char* end = begin + input.length();
+            size_t offset = input.empty() ? 0 : generator() % input.length();
+
+            for (Isa isa : kIsas) {
+                const Kernels& kernels = GetKernels(isa);
+                if (kernels.findChar(begin + offset, end, ':') != reference.findChar(begin + offset, end, ':')) Fail("findChar", isa, input);
+                if (kernels.findCRLF(begin + offset, end) != reference.findCRLF(begin + offset, end)) Fail("findCRLF", isa, input);
+                if (kernels.findNonToken(begin + offset, end) != reference.findNonToken(begin + offset, end)) Fail("findNonToken", isa, input);
+                if (kernels.findNonFieldValue(begin + offset, end) != reference.findNonFieldValue(begin + offset, end)) Fail("findNonFieldValue", isa, input);
+            }
+        }
+        std::printf("fuzz: %d random inputs matched the scalar kernels\n\n", FUZZ_ITERATIONS);
+    }
+
+    template <typename Fn>
+    double BytesPerTick(size_t bytes, Fn fn) {
+        // Warm up caches and wide vector units before timing
+        for (int i = 0; i < BENCH_ITERATIONS; ++i) {
+            fn();
+        }
+        unsigned long long start = ReadCounter();
+        for (int i = 0; i < BENCH_ITERATIONS; ++i) {
+            fn();
+        }
+        unsigned long long ticks = ReadCounter() - start;
+        return static_cast<double>(bytes) * BENCH_ITERATIONS / ticks;
+    }
+}
+
+int main() {
+    std::printf("detected: %s\n", GetIsaName(DetectIsa()));
+    Fuzz();
+
+    std::printf("%-24s %-8s %10s %14s\n", "request", "isa", "kernels", "FromString");
+    struct { const char* name; size_t cookie; int headers; } workloads[] = {
+        {"small (8 headers)", 0, 6},
+        {"2KB cookie", 2048, 6},
+        {"3KB cookie, 40 headers", 3072, 40},
+    };
+
+    for (const auto& workload : workloads) {
+        const std::string request = MakeRequest(workload.cookie, workload.headers);
+        for (Isa isa : kIsas) {
+            const Kernels& kernels = GetKernels(isa);
+            double scanRate = BytesPerTick(request.length(), [&] {
+                gSink = ScanHeaders(kernels, request);
+            });
+            SelectIsa(isa);
+            double parseRate = BytesPerTick(request.length(), [&] {
+                HttpRequest parsed = FromString<HttpRequest>(request);
+                gSink = parsed.FindHeader("Cookie", nullptr);
+            });
+            std::printf("%-24s %-8s %10.2f %14.2f\n", workload.name, GetIsaName(isa), scanRate, parseRate);
+        }
+    }
+    std::printf("\n(bytes per %s, %d iterations each)\n", kCounterUnit, BENCH_ITERATIONS);
+    return 0;
+}
@@ -0,0 +1,234 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "../include/http/http_message.h"
+#include "../include/http/http_server.h"
+
+using httpserver::HttpMethod;
+using httpserver::HttpRequest;
+using httpserver::HttpResponse;
+using httpserver::HttpServer;
+using httpserver::HttpStatusCode;
+using httpserver::ListenerConfig;
+using httpserver::TlsConfig;
+using httpserver::TlsStats;
+
+namespace {
+    constexpr std::uint16_t PLAIN_PORT = 18110;
+    constexpr std::uint16_t TLS_PORT = 18111;
+    constexpr int HANDSHAKES = 300;
+    constexpr size_t BULK_SIZE = 256 * 1024;
+    constexpr auto RUN_TIME = std::chrono::milliseconds(2000);
+
+    const char kSmallRequest[] = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    const char kBulkRequest[] = "GET /bulk HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+    // Self-signed P-256 certificate for CN=localhost, valid for a day
+    bool WriteCertificate(const char* certificatePath, const char* keyPath) {
+        EVP_PKEY* key = EVP_EC_gen("P-256");
+        X509* certificate = X509_new();
+        if (key == nullptr || certificate == nullptr) return false;
+
+        ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+        X509_gmtime_adj(X509_getm_notBefore(certificate), 0);
+        X509_gmtime_adj(X509_getm_notAfter(certificate), 24 * 60 * 60);
+        X509_set_pubkey(certificate, key);
+        X509_NAME* name = X509_get_subject_name(certificate);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(certificate, name);
+        bool isSigned = X509_sign(certificate, key, EVP_sha256()) > 0;
+
+        FILE* certificateFile = std::fopen(certificatePath, "w");
+        FILE* keyFile = std::fopen(keyPath, "w");
+        bool written = isSigned && certificateFile && keyFile &&
+                       PEM_write_X509(certificateFile, certificate) == 1 &&
+                       PEM_write_PrivateKey(keyFile, key, nullptr, nullptr, 0, nullptr, nullptr) == 1;
+        if (certificateFile) std::fclose(certificateFile);
+        if (keyFile) std::fclose(keyFile);
+        X509_free(certificate);
+        EVP_PKEY_free(key);
+        return written;
+    }
+
+    int Connect(std::uint16_t port) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    // Blocking client connection, TLS when ssl is set
+    struct Client {
+        int fd;
+        SSL* ssl;
+
+        ssize_t Read(char* buffer, size_t length) {
+            return ssl ? SSL_read(ssl, buffer, static_cast<int>(length)) : recv(fd, buffer, length, 0);
+        }
+
+        bool Write(const char* buffer, size_t length) {
+            ssize_t written = ssl ? SSL_write(ssl, buffer, static_cast<int>(length)) : send(fd, buffer, length, 0);
+            return written == static_cast<ssize_t>(length);
+        }
+
+        // Sends request and reads the whole response, returns the body size or 0 on failure
+        size_t RoundTrip(const char* request, size_t length) {
+            if (!Write(request, length)) return 0;
+            std::string response;
+            char buffer[65536];
+            size_t headerEnd = std::string::npos;
+            size_t total = 0;
+            while (headerEnd == std::string::npos || response.size() < total) {
+                ssize_t count = Read(buffer, sizeof(buffer));
+                if (count <= 0) return 0;
+                response.append(buffer, count);
+                if (headerEnd == std::string::npos && (headerEnd = response.find("\r\n\r\n")) != std::string::npos) {
+                    size_t field = response.find("Content-Length: ");
+                    size_t body = field == std::string::npos ? 0 : std::strtoul(response.c_str() + field + 16, nullptr, 10);
+                    total = headerEnd + 4 + body;
+                }
+            }
+            return total - headerEnd - 4;
+        }
+
+        void Close() {
+            if (ssl) {
+                SSL_shutdown(ssl);
+                SSL_free(ssl);
+            }
+            close(fd);
+        }
+    };
+
+    bool Open(Client* client, std::uint16_t port, SSL_CTX* context, SSL_SESSION* session) {
+        client->fd = Connect(port);
+        client->ssl = nullptr;
+        if (client->fd < 0) return false;
+        if (context == nullptr) return true;
+
+        client->ssl = SSL_new(context);
+        SSL_set_fd(client->ssl, client->fd);
+        if (session) SSL_set_session(client->ssl, session);
+        return SSL_connect(client->ssl) == 1;
+    }
+
+    // New connection, one request, close. Resumes from the first connection's ticket when asked to.
+    void MeasureHandshakes(const char* name, SSL_CTX* context, bool resume) {
+        SSL_SESSION* session = nullptr;
+        int resumed = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < HANDSHAKES; ++i) {
+            Client client;
+            if (!Open(&client, TLS_PORT, context, session) || client.RoundTrip(kSmallRequest, sizeof(kSmallRequest) - 1) == 0) {
+                std::fprintf(stderr, "%s: connection %d failed\n", name, i);
+                client.Close();
+                break;
+            }
+            resumed += SSL_session_reused(client.ssl);
+            // TLS 1.3 tickets arrive after the handshake, so the session is taken once the response is in
+            if (resume && session == nullptr) session = SSL_get1_session(client.ssl);
+            client.Close();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-24s %12.0f conn/s %8d resumed\n", name, HANDSHAKES / seconds, resumed);
+        SSL_SESSION_free(session);
+    }
+
+    // Keep-alive requests on one connection for RUN_TIME, reports requests and body bytes per second
+    void MeasureKeepAlive(const char* name, std::uint16_t port, SSL_CTX* context, const char* request, size_t length) {
+        Client client;
+        if (!Open(&client, port, context, nullptr)) {
+            std::fprintf(stderr, "%s: connect failed\n", name);
+            return;
+        }
+        std::uint64_t requests = 0;
+        std::uint64_t bytes = 0;
+        auto start = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - start < RUN_TIME) {
+            size_t body = client.RoundTrip(request, length);
+            if (body == 0) break;
+            ++requests;
+            bytes += body;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-24s %12.0f req/s %10.1f MB/s\n", name, requests / seconds, bytes / seconds / 1e6);
+        client.Close();
+    }
+}
+
+int main() {
+    const char* certificatePath = "/tmp/http_server_tls_bench_cert.pem";
+    const char* keyPath = "/tmp/http_server_tls_bench_key.pem";
+    if (!WriteCertificate(certificatePath, keyPath)) {
+        std::fprintf(stderr, "Failed to write the self-signed certificate\n");
+        return 1;
+    }
+
+    HttpServer server("127.0.0.1", PLAIN_PORT);
+    server.AddListener(ListenerConfig::Https("127.0.0.1", TLS_PORT, TlsConfig(certificatePath, keyPath)));
+    std::string bulk(BULK_SIZE, 'x');
+    server.RegisterRequestHandler("/", HttpMethod::GET, [](const HttpRequest&) {
+        HttpResponse response(HttpStatusCode::OK);
+        response.SetContent("test\n");
+        return response;
+    });
+    server.RegisterRequestHandler("/bulk", HttpMethod::GET, [&bulk](const HttpRequest&) {
+        HttpResponse response(HttpStatusCode::OK);
+        response.SetContent(bulk);
+        return response;
+    });
+    server.Start();
+
+    SSL_CTX* tls12 = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_max_proto_version(tls12, TLS1_2_VERSION);
+    SSL_CTX* tls13 = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_min_proto_version(tls13, TLS1_3_VERSION);
+
+    std::printf("%d handshakes per row, keep-alive rows run for %lld ms\n\n", HANDSHAKES,
+                static_cast<long long>(RUN_TIME.count()));
+    MeasureHandshakes("TLS 1.2 full", tls12, false);
+    MeasureHandshakes("TLS 1.2 resumed", tls12, true);
+    MeasureHandshakes("TLS 1.3 full", tls13, false);
+    MeasureHandshakes("TLS 1.3 resumed", tls13, true);
+    std::printf("\n");
+    MeasureKeepAlive("plain small", PLAIN_PORT, nullptr, kSmallRequest, sizeof(kSmallRequest) - 1);
+    MeasureKeepAlive("TLS 1.3 small", TLS_PORT, tls13, kSmallRequest, sizeof(kSmallRequest) - 1);
+    MeasureKeepAlive("plain 256 KB", PLAIN_PORT, nullptr, kBulkRequest, sizeof(kBulkRequest) - 1);
+    MeasureKeepAlive("TLS 1.3 256 KB", TLS_PORT, tls13, kBulkRequest, sizeof(kBulkRequest) - 1);
+
+    TlsStats stats = server.GetListeners()[1]->GetTls()->GetStats();
+    std::printf("\nserver: %llu handshakes, %llu resumed, kTLS send on %llu, receive on %llu\n",
+                static_cast<unsigned long long>(stats.handshakes), static_cast<unsigned long long>(stats.resumed),
+                static_cast<unsigned long long>(stats.kernelSend), static_cast<unsigned long long>(stats.kernelReceive));
+
+    SSL_CTX_free(tls12);
+    SSL_CTX_free(tls13);
+    server.Stop();
+    unlink(certificatePath);
+    unlink(keyPath);
+    return 0;
+}
\ No newline at end of file
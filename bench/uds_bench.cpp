@@ -0,0 +1,150 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "../include/http/http_message.h"
+#include "../include/http/http_server.h"
+
+using httpserver::HttpMethod;
+using httpserver::HttpRequest;
+using httpserver::HttpResponse;
+using httpserver::HttpServer;
+using httpserver::HttpStatusCode;
+using httpserver::Listener;
+using httpserver::ListenerConfig;
+using httpserver::ListenerType;
+
+namespace {
+    constexpr int LATENCY_REQUESTS = 20000;
+    constexpr int THROUGHPUT_CONNECTIONS = 4;
+    constexpr auto THROUGHPUT_TIME = std::chrono::milliseconds(2000);
+    const char kAbstractName[] = "http_server_uds_bench";
+
+    const char kRequest[] = "GET / HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n\r\n";
+
+    int Connect(const Listener& listener) {
+        const ListenerConfig& config = listener.GetConfig();
+        sockaddr_storage address;
+        socklen_t length;
+        std::memset(&address, 0, sizeof(address));
+
+        int fd;
+        if (config.type == ListenerType::Unix) {
+            sockaddr_un* unixAddress = reinterpret_cast<sockaddr_un*>(&address);
+            unixAddress->sun_family = AF_UNIX;
+            std::memcpy(unixAddress->sun_path + 1, kAbstractName, sizeof(kAbstractName) - 1);
+            length = offsetof(sockaddr_un, sun_path) + sizeof(kAbstractName);
+            fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        } else if (config.address == "::1") {
+            sockaddr_in6* ipv6 = reinterpret_cast<sockaddr_in6*>(&address);
+            ipv6->sin6_family = AF_INET6;
+            ipv6->sin6_port = htons(listener.GetPort());
+            inet_pton(AF_INET6, "::1", &ipv6->sin6_addr);
+            length = sizeof(sockaddr_in6);
+            fd = socket(AF_INET6, SOCK_STREAM, 0);
+        } else {
+            sockaddr_in* ipv4 = reinterpret_cast<sockaddr_in*>(&address);
+            ipv4->sin_family = AF_INET;
+            ipv4->sin_port = htons(listener.GetPort());
+            inet_pton(AF_INET, config.address.c_str(), &ipv4->sin_addr);
+            length = sizeof(sockaddr_in);
+            fd = socket(AF_INET, SOCK_STREAM, 0);
+        }
+
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), length) < 0) {
+            std::perror("connect");
+            return -1;
+        }
+        if (config.type == ListenerType::TCP) {
+            int enable = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        }
+        return fd;
+    }
+
+    bool RoundTrip(int fd) {
+        char buffer[1024];
+        if (send(fd, kRequest, sizeof(kRequest) - 1, 0) != static_cast<ssize_t>(sizeof(kRequest) - 1)) {
+            return false;
+        }
+        while (true) {
+            ssize_t count = recv(fd, buffer, sizeof(buffer), 0);
+            if (count <= 0) return false;
+            if (buffer[count - 1] == '\n') return true;
+        }
+    }
+
+    void Measure(const Listener& listener) {
+        // Latency, one connection in a closed loop
+        int fd = Connect(listener);
+        if (fd < 0) return;
+        std::vector<double> latencies;
+        latencies.reserve(LATENCY_REQUESTS);
+        for (int i = 0; i < LATENCY_REQUESTS; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            if (!RoundTrip(fd)) {
+                std::fprintf(stderr, "%s: request failed\n", listener.Describe().c_str());
+                return;
+            }
+            latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        }
+        close(fd);
+        std::sort(latencies.begin(), latencies.end());
+
+        // Throughput, several connections in parallel
+        std::atomic<bool> running{true};
+        std::atomic<std::uint64_t> completed{0};
+        std::vector<std::thread> clients;
+        for (int i = 0; i < THROUGHPUT_CONNECTIONS; ++i) {
+            clients.emplace_back([&] {
+                int client = Connect(listener);
+                while (client >= 0 && running && RoundTrip(client)) {
+                    completed.fetch_add(1, std::memory_order_relaxed);
+                }
+                close(client);
+            });
+        }
+        std::this_thread::sleep_for(THROUGHPUT_TIME);
+        running = false;
+        for (std::thread& client : clients) {
+            client.join();
+        }
+
+        double seconds = std::chrono::duration<double>(THROUGHPUT_TIME).count();
+        std::printf("%-28s %9.1f %9.1f %12.0f\n", listener.Describe().c_str(),
+                    latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100], completed / seconds);
+    }
+}
+
+int main() {
+    HttpServer server;
+    server.AddListener(ListenerConfig::Tcp("127.0.0.1", 0));
+    server.AddListener(ListenerConfig::Tcp("::1", 0));
+    server.AddListener(ListenerConfig::Unix(std::string("@") + kAbstractName));
+    server.RegisterRequestHandler("/", HttpMethod::GET, [](const HttpRequest&) {
+        HttpResponse response(HttpStatusCode::OK);
+        response.SetHeader("Content-Type", "text/plain");
+        response.SetContent("hello\n");
+        return response;
+    });
+    server.Start();
+
+    std::printf("%-28s %9s %9s %12s\n", "listener", "p50 us", "p99 us", "req/s");
+    for (const auto& listener : server.GetListeners()) {
+        Measure(*listener);
+    }
+    server.Stop();
+    return 0;
+}
\ No newline at end of file
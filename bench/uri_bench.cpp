@@ -0,0 +1,82 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../include/http/uri.h"
+#include "../include/http/uri_view.h"
+
+using httpserver::StringView;
+using httpserver::URI;
+using httpserver::URIView;
+
+namespace {
+    constexpr int ITERATIONS = 1000000;
+    volatile size_t gSink;
+
+    std::string MakeUrl(int paramCount) {
+        std::string url = "/api/v2/search/Products";
+        for (int i = 0; i < paramCount; ++i) {
+            url += (i == 0 ? '?' : '&');
+            url += "param" + std::to_string(i) + "=Value%20" + std::to_string(i * 7919) + "+Tail";
+        }
+        return url;
+    }
+
+    // Old class has no parameter lookup, handlers split GetQuery() themselves
+    size_t LookupWithURI(const URI& uri, const std::string& key) {
+        std::string query = uri.GetQuery();
+        size_t pos = 0;
+        while (pos < query.length()) {
+            size_t end = query.find('&', pos);
+            if (end == std::string::npos) end = query.length();
+            std::string pair = query.substr(pos, end - pos);
+            size_t equals = pair.find('=');
+            if (pair.substr(0, equals) == key) {
+                return pair.substr(equals + 1).length();
+            }
+            pos = end + 1;
+        }
+        return 0;
+    }
+
+    template <typename Fn>
+    double Measure(Fn fn) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ITERATIONS; ++i) {
+            fn();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS;
+    }
+}
+
+int main() {
+    std::printf("%-8s %-12s %12s %12s\n", "params", "workload", "URI ns/op", "URIView ns/op");
+    for (int paramCount : {5, 10, 20}) {
+        const std::string url = MakeUrl(paramCount);
+        const std::string key = "param" + std::to_string(paramCount - 1);
+
+        double uriPath = Measure([&] {
+            URI uri(url);
+            gSink = uri.GetPath().length() + uri.GetQuery().length();
+        });
+        double viewPath = Measure([&] {
+            URIView uri(url.data(), url.length());
+            gSink = uri.GetPath().Length() + uri.GetRawQuery().Length();
+        });
+        std::printf("%-8d %-12s %12.1f %12.1f\n", paramCount, "path", uriPath, viewPath);
+
+        double uriLookup = Measure([&] {
+            URI uri(url);
+            gSink = LookupWithURI(uri, key);
+        });
+        double viewLookup = Measure([&] {
+            URIView uri(url.data(), url.length());
+            StringView value;
+            gSink = uri.FindQueryParam(key, &value) ? value.Length() : 0;
+        });
+        std::printf("%-8d %-12s %12.1f %12.1f\n", paramCount, "last-param", uriLookup, viewLookup);
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "http_server_config.h"
+#include "peer_address.h"
+#include "../utils/spsc_ring.h"
+#include "../utils/string_view.h"
+
+namespace httpserver {
+    enum class AccessLogFormat {
+        Common,
+        Combined,
+        JsonLines
+    };
+
+    // Fixed-size record copied into a worker ring, strings are truncated to fit
+    struct AccessLogRecord {
+        std::int64_t timestampUs;       // Wall clock, microseconds since epoch
+        std::uint32_t latencyUs;        // Time spent parsing, handling and serializing
+        std::uint32_t bytes;            // Response bytes queued for sending
+        std::uint16_t status;
+        std::uint8_t method;            // HttpMethod, or METHOD_UNKNOWN when parsing failed
+        std::uint8_t pathLength;
+        std::uint8_t refererLength;
+        std::uint8_t userAgentLength;
+        PeerAddress peer;
+        char path[config::ACCESS_LOG_PATH_SIZE];
+        char referer[config::ACCESS_LOG_FIELD_SIZE];
+        char userAgent[config::ACCESS_LOG_FIELD_SIZE];
+
+        static constexpr std::uint8_t METHOD_UNKNOWN = 0xFF;
+    };
+
+    // Workers push records into their own SPSC ring, a background thread formats and writes them
+    // in batches. A full ring drops the record and counts it instead of blocking the worker.
+    class AccessLog {
+    public:
+        AccessLog(const std::string& path, AccessLogFormat format);
+        ~AccessLog();
+
+        AccessLog(const AccessLog&) = delete;
+        AccessLog& operator=(const AccessLog&) = delete;
+
+        // Sample rate in [0, 1] for requests whose normalized path equals route, configure before Start
+        void SetSampleRate(const std::string& route, double rate);
+        void SetDefaultSampleRate(double rate);
+
+        void Start();
+        void Stop();
+
+        // Called from the owning worker only
+        bool ShouldSample(int workerId, StringView route);
+        void Push(int workerId, const AccessLogRecord& record);
+
+        // Safe to call from any thread, the writer reopens the file on its next pass
+        void Reopen();
+
+        std::uint64_t GetDroppedCount() const;
+        std::uint64_t GetWrittenCount() const;
+
+    private:
+        using Ring = SpscRing<AccessLogRecord, config::ACCESS_LOG_RING_SIZE>;
+
+        // Per-worker producer state, padded so workers never share a cache line
+        struct WorkerState {
+            std::atomic<std::uint64_t> dropped;
+            std::uint64_t randomState;
+            char padding[64 - sizeof(std::atomic<std::uint64_t>) - sizeof(std::uint64_t)];
+        };
+
+        std::string _path;
+        AccessLogFormat _format;
+        int _fd;
+        std::atomic<bool> _running;
+        std::atomic<bool> _reopenRequested;
+        std::atomic<std::uint64_t> _written;
+        std::thread _writerThread;
+
+        std::uint64_t _defaultThreshold;
+        std::map<std::string, std::uint64_t, std::less<>> _routeThresholds;
+
+        std::unique_ptr<Ring> _rings[config::WORKER_POOL_SIZE];
+        WorkerState _workers[config::WORKER_POOL_SIZE];
+
+        std::unique_ptr<char[]> _buffer;
+        size_t _bufferLength;
+        std::int64_t _cachedSecond;
+        char _cachedTime[32];
+        size_t _cachedTimeLength;
+
+        void OpenFile();
+        void Run();
+        void Flush();
+        void Format(const AccessLogRecord& record);
+        void FormatTime(std::int64_t timestampUs);
+        void Append(const char* data, size_t length);
+        void AppendEscaped(const char* data, size_t length, bool json);
+        void AppendNumber(std::uint64_t value);
+    };
+}
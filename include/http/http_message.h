@@ -3,6 +3,9 @@
 #include <string>
 
 #include "uri.h"
+#include "uri_view.h"
+#include "../utils/arena.h"
+#include "../utils/string_view.h"
 
 namespace httpserver {
     enum class HttpMethod {
@@ -24,6 +27,7 @@ namespace httpserver {
     };
 
     enum class HttpStatusCode {
+        SwitchingProtocols = 101,
         OK = 200,
         Created = 201,
         NoContent = 204,
@@ -32,6 +36,8 @@ namespace httpserver {
         Forbidden = 403,
         NotFound = 404,
         MethodNotAllowed = 405,
+        UpgradeRequired = 426,
+        TooManyRequests = 429,
         InternalServerError = 500,
         NotImplemented = 501,
         BadGateway = 502,
@@ -40,29 +46,58 @@ namespace httpserver {
         HttpVersionNotSupported = 505
     };
 
+    // Headers and content are allocated from the worker's request arena while a request is being
+    // served, so messages created in a handler must not outlive the response. GetHeaders and
+    // GetContent return copies that may be kept, views are only valid while the message is.
     class HttpMessage {
     public:
         HttpMessage();
         virtual ~HttpMessage() = default;
 
-        void SetHeader(const std::string& key, const std::string& value);
-        void RemoveHeader(const std::string& key);
+        void SetHeader(StringView key, StringView value);
+        void RemoveHeader(StringView key);
         void ClearHeaders();
-        void SetContent(const std::string& content);
+        void SetContent(StringView content);
+        void SetContent(const char* content);
+        void SetContent(ArenaString&& content);
         void ClearContent();
 
         HttpVersion GetVersion() const;
-        std::string GetHeader(const std::string& key) const;
-        const std::map<std::string, std::string>& GetHeaders() const;
-        const std::string& GetContent() const;
+        std::string GetHeader(StringView key) const;
+        // Returns false when missing, the view stays valid until the header changes
+        bool FindHeader(StringView key, StringView* value) const;
+        // Same, with the name matched without regard to case as HTTP requires. Headers are stored as
+        // received, so this falls back to a linear scan when the exact spelling is missing.
+        bool FindHeaderIgnoreCase(StringView key, StringView* value) const;
+        std::map<std::string, std::string> GetHeaders() const;
+        // Calls fn(StringView name, StringView value) for each header in order, without copying
+        template <typename Fn>
+        void ForEachHeader(Fn fn) const;
+        std::string GetContent() const;
+        // The view stays valid until the content changes
+        StringView GetContentView() const;
         size_t GetContentLength() const;
+        // Arena backing this message, null when created outside a request
+        Arena* GetArena() const;
 
     protected:
+        using HeaderMap = ArenaMap<ArenaString, ArenaString>;
+
         HttpVersion _version;
-        std::map<std::string, std::string> _headers;
-        std::string _content;
+        HeaderMap _headers;
+        ArenaString _content;
+
+    private:
+        void UpdateContentLength();
     };
 
+    template <typename Fn>
+    void HttpMessage::ForEachHeader(Fn fn) const {
+        for (const auto& header : _headers) {
+            fn(StringView(header.first), StringView(header.second));
+        }
+    }
+
     class HttpRequest : public HttpMessage {
     public:
         HttpRequest() = default;
@@ -70,13 +105,17 @@ namespace httpserver {
 
         void SetMethod(HttpMethod method);
         void SetURI(const URI& uri);
+        // The view references the request buffer, which must outlive this request
+        void SetURIView(const URIView& uriView);
 
         HttpMethod GetMethod() const;
         const URI& GetURI() const;
+        const URIView& GetURIView() const;
 
     private:
         HttpMethod _method;
-        URI _uri;
+        mutable URI _uri;
+        URIView _uriView;
     };
 
     class HttpResponse : public HttpMessage {
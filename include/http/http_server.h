@@ -5,66 +5,189 @@
 
 #include <chrono>
 #include <functional>
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <random>
 #include <string>
 #include <thread>
+#include <unordered_set>
+#include <vector>
 
+#include "access_log.h"
+#include "../utils/arena.h"
 #include "http_message.h"
+#include "listener.h"
+#include "load_balancer.h"
+#include "peer_address.h"
+#include "process_stats.h"
+#include "rate_limiter.h"
+#include "request_trace.h"
 #include "uri.h"
+#include "websocket.h"
 #include "http_server_config.h"
 
 namespace httpserver {
 
+    // Each connection owns a request and a response buffer, linked through pair and reused for
+    // every request on the connection. After an upgrade the request side owns the WebSocket session,
+    // the response side only holds it until the 101 response is flushed. Responses that do not fit
+    // in buffer are serialized into overflow instead. Both sides share the TLS session of a connection
+    // accepted on a TLS listener, the request side drives its handshake. In prefork mode each shared listening socket
+    // is also registered through an EventData, which only sets fd and listener.
     struct EventData {
         int fd;
+        int workerId;
+        Listener* listener;
         size_t length;
         size_t cursor;
+        PeerAddress peer;
+        EventData* pair;
+        TlsSession* tls;
+        WebSocketConnection* webSocket;
+        WebSocketConnection* pendingWebSocket;
+        bool traced;
+        RequestTrace trace;
+        std::string overflow;
         char buffer[config::MAX_BUFFER_SIZE];
-        EventData() : fd(0), length(0), cursor(0), buffer() {}
+        EventData() : fd(0), workerId(0), listener(nullptr), length(0), cursor(0), peer(), pair(nullptr),
+                      tls(nullptr), webSocket(nullptr), pendingWebSocket(nullptr), traced(false), trace(), buffer() {}
     };
 
     using HttpRequestHandler = std::function<HttpResponse(const HttpRequest&)>;
 
     class HttpServer {
     public:
+        // Listens on host:port, further endpoints can be added with AddListener
         explicit HttpServer(const std::string& host, std::uint16_t port);
         HttpServer(HttpServer&&) noexcept;
         HttpServer& operator=(HttpServer&&) noexcept;
-        HttpServer() = default;
+        HttpServer();
         ~HttpServer() = default;
 
         void Start();
+        // Opens the listeners, then forks processes worker processes that each accept on them and run
+        // one event loop. The master restarts workers that exit and serves their counters on the
+        // stats listener. Returns once the workers are forked, Stop ends them all. Rate limiter buckets
+        // and TLS counters stay per process: a limit of N per second admits up to N * processes, and
+        // TlsContext::GetStats in a worker covers only that worker's connections.
+        void StartPrefork(int processes);
         void Stop();
         void RegisterRequestHandler(std::string path, HttpMethod method, const HttpRequestHandler callback);
 
+        // Listeners must be added before Start, all of them share the router and the workers
+        void AddListener(const ListenerConfig& config);
+        const std::vector<std::unique_ptr<Listener>>& GetListeners() const;
+
+        // Every request on the stats listener gets the prefork counters as plain text, set before StartPrefork
+        void SetProcessStatsListener(const ListenerConfig& config);
+        std::vector<ProcessStats> GetProcessStats() const;
+
+        // Access log must be enabled and sampled before Start
+        void EnableAccessLog(const std::string& path, AccessLogFormat format);
+        void SetAccessLogSampleRate(std::string path, double rate);
+        void ReopenAccessLog();
+        std::uint64_t GetDroppedAccessLogRecords() const;
+
+        // Rate limiting must be enabled before Start
+        void EnableRateLimit(const RateLimitConfig& config);
+        std::uint64_t GetRateLimitedCount() const;
+
+        // Placement and rebalancing must be configured before Start, round-robin by default
+        void SetLoadBalancing(const LoadBalancerConfig& config);
+        WorkerLoadStats GetWorkerLoad(int workerId) const;
+        double GetLoadImbalance() const;
+
+        // Samples sampleRate of requests into phase traces, reported as text on GET debugPath and as
+        // Chrome trace-event JSON on GET debugPath?format=chrome. Must be enabled before Start.
+        void EnableRequestTracing(double sampleRate, std::string debugPath = "/debug/trace");
+
+        // WebSocket handlers must be registered before Start
+        void RegisterWebSocketHandler(std::string path, const WebSocketHandler handler);
+        // Safe to call from any thread, the frame is built once and shared by every session on path
+        void BroadcastWebSocket(const std::string& path, WebSocketOpcode opcode, StringView payload);
+
         std::string GetHost() const;
         std::uint16_t GetPort() const;
         bool IsRunning() const;
 
     private:
+        struct WebSocketBroadcast {
+            std::string path;
+            WebSocketFrame frame;
+        };
+
+        // Broadcasts are handed to each worker, which writes them to the sessions it owns
+        struct WebSocketMailbox {
+            std::mutex mutex;
+            std::vector<WebSocketBroadcast> broadcasts;
+            std::atomic<bool> pending;
+            WebSocketMailbox() : pending(false) {}
+        };
+
         std::string _host;
         std::uint16_t _port;
-        int _socketFd;
+        std::vector<std::unique_ptr<Listener>> _listeners;
         bool _running;
 
         std::thread _listenerThread;
         std::thread _workerThreads[config::WORKER_POOL_SIZE];
+        int _workerCount;
+
+        // Prefork master state, _processSlot is only set inside a worker process
+        std::unique_ptr<ProcessStatsSegment> _processStats;
+        std::unique_ptr<Listener> _statsListener;
+        std::vector<pid_t> _workerPids;
+        std::vector<std::chrono::steady_clock::time_point> _workerStarts;
+        std::thread _supervisorThread;
+        std::atomic<bool> _reopenWorkers;
+        int _processSlot;
         
         int _workerEpollFd[config::WORKER_POOL_SIZE];
         epoll_event _workerEvents[config::WORKER_POOL_SIZE][config::MAX_EVENTS];
-        std::map<std::string, std::map<HttpMethod, HttpRequestHandler>> _requestHandlers;
+        // Transparent comparator allows router lookups by StringView without building a key
+        std::map<std::string, std::map<HttpMethod, HttpRequestHandler>, std::less<>> _requestHandlers;
+        Arena _workerArenas[config::WORKER_POOL_SIZE];
+        std::unique_ptr<AccessLog> _accessLog;
+        std::unique_ptr<RateLimiter> _rateLimiter;
+        std::unique_ptr<RequestTracer> _tracer;
+        std::unique_ptr<LoadBalancer> _loadBalancer;
+        std::uint64_t _traceBatchStart[config::WORKER_POOL_SIZE];
+        std::map<std::string, WebSocketHandler, std::less<>> _webSocketHandlers;
+        std::unordered_set<EventData*> _webSocketSessions[config::WORKER_POOL_SIZE];
+        WebSocketMailbox _webSocketMailboxes[config::WORKER_POOL_SIZE];
         std::mt19937 _randomGenerator;
         std::uniform_int_distribution<int> _sleepTimeRange;
 
-        void CreateSocket();
         void Initialize();
         void Listen();
+        bool RejectAtAccept(int clientFd, const PeerAddress& peer, int shard);
+        bool AddConnection(int clientFd, const PeerAddress& peer, int worker, TlsContext* tls);
+        void AcceptConnections(int workerId, Listener& listener);
+        pid_t SpawnWorkerProcess(int slot);
+        void RunWorkerProcess(int slot, pid_t master);
+        void Supervise();
+        void ReapWorkerProcesses();
+        void ServeProcessStats();
+        void StopWorkerProcesses();
         void ProcessEvents(int workerId);
+        void ContinueHandshake(int epollFd, EventData* data);
         void Receive(int epollFd, EventData* data);
         void Send(int epollFd, EventData* data);
         void ControlEvent(int epollFd, int op, int fd, std::uint32_t events = 0, void* data = nullptr);
+        void CloseConnection(int epollFd, EventData* data);
+        void MigrateConnection(int epollFd, EventData* request, int targetWorker);
         void ProcessData(const EventData& request, EventData* response);
+        void FinishTrace(EventData* response);
+        bool IsRateLimited(const EventData& rawRequest, const HttpRequest* request);
+        void LogAccess(const EventData& rawRequest, const HttpRequest& request, HttpStatusCode status,
+                       size_t bytes, std::chrono::steady_clock::time_point start);
         HttpResponse HandleRequest(const HttpRequest& request);
+        const WebSocketHandler* FindWebSocketHandler(const HttpRequest& request) const;
+        HttpResponse AcceptWebSocket(const HttpRequest& request, const WebSocketHandler* handler, EventData* rawResponse);
+        void OpenWebSocket(int epollFd, EventData* response);
+        void HandleWebSocketEvent(int epollFd, EventData* data, std::uint32_t events);
+        void DrainWebSocketMailbox(int epollFd, int workerId);
     };
 }
\ No newline at end of file
@@ -4,6 +4,13 @@ namespace httpserver {
     namespace config {
         // Buffer settings
         constexpr size_t MAX_BUFFER_SIZE = 4096;        // Max bytes per HTTP request/response
+
+        // Arena settings
+        constexpr size_t ARENA_BLOCK_SIZE = 16384;      // Initial per-worker request arena size
+        constexpr size_t ARENA_MAX_BLOCK_SIZE = 1 << 20;// Arena never grows its retained block past this
+
+        // URI settings
+        constexpr size_t MAX_QUERY_PARAMS = 32;         // Query parameters kept in the flat index
         
         // Server settings
         constexpr int BACKLOG_SIZE = 1000;              // Pending connections queue size
@@ -11,6 +18,45 @@ namespace httpserver {
         constexpr int MAX_EVENTS = 2048;                // Max epoll events per worker
         constexpr int WORKER_POOL_SIZE = 8;             // Number of worker threads
         
+        // Access log settings
+        constexpr size_t ACCESS_LOG_RING_SIZE = 4096;   // Records buffered per worker (power of two)
+        constexpr size_t ACCESS_LOG_BATCH_SIZE = 256;   // Records drained from one ring per pass
+        constexpr size_t ACCESS_LOG_BUFFER_SIZE = 65536;// Formatted bytes collected before a write
+        constexpr size_t ACCESS_LOG_PATH_SIZE = 128;    // Request-target bytes kept per record
+        constexpr size_t ACCESS_LOG_FIELD_SIZE = 64;    // Referer/User-Agent bytes kept per record
+        constexpr int ACCESS_LOG_IDLE_SLEEP = 1000;     // Writer sleep (us) when all rings are empty
+
+        // Rate limit settings
+        constexpr size_t RATE_LIMIT_TABLE_SIZE = 4096;  // Buckets per shard (power of two)
+        constexpr size_t RATE_LIMIT_PROBE_LENGTH = 8;   // Slots searched before evicting
+        constexpr int RATE_LIMIT_RECONCILE_INTERVAL = 50; // Shard reconciliation period (ms)
+
+        // WebSocket settings
+        constexpr size_t WEBSOCKET_READ_SIZE = 16384;   // Bytes requested per recv
+        constexpr size_t WEBSOCKET_MAX_MESSAGE_SIZE = 1 << 20;  // Largest reassembled message
+        constexpr size_t WEBSOCKET_MAX_QUEUED_BYTES = 4 << 20;  // Unsent bytes before a slow client is dropped
+        constexpr int WEBSOCKET_MAX_IOVECS = 64;        // Frames gathered per writev
+
+        // Request tracing settings
+        constexpr size_t TRACE_RING_SIZE = 1024;        // Sampled requests buffered per worker
+        constexpr size_t TRACE_PATH_SIZE = 48;          // Request target bytes kept per record
+        constexpr size_t TRACE_SLOWEST_COUNT = 32;      // Requests kept for the slowest-N report and export
+        constexpr int TRACE_HISTOGRAM_BUCKETS = 32;     // Power of two nanosecond buckets, up to about 2s
+
+        // Load balancing settings
+        constexpr int LOAD_SAMPLE_INTERVAL = 50;        // Worker load sampling period (ms)
+        constexpr double LOAD_SMOOTHING = 0.5;          // Weight of the newest sample in the recent load
+        constexpr double LOAD_MIN_REBALANCE = 0.10;     // Busiest worker load below which nothing moves
+        constexpr int LOAD_MIGRATION_BATCH = 4;         // Connections moved off a worker per period
+
+        // Prefork settings
+        constexpr int PREFORK_ACCEPT_BATCH = 64;        // Connections a worker process accepts per listener event
+        constexpr int PREFORK_SUPERVISE_INTERVAL = 100; // Master reap and restart period (ms)
+        constexpr int PREFORK_RESTART_DELAY = 1000;     // Min time (ms) between two starts of one worker process
+        constexpr int PREFORK_STOP_TIMEOUT = 5000;      // Wait (ms) for worker processes to exit before SIGKILL
+        constexpr int PREFORK_STATS_READ_TIMEOUT = 100; // Wait (ms) for the request on a stats connection
+        constexpr int PREFORK_EPOLL_TIMEOUT = 10;       // Blocking wait (ms) of a worker process's event loop
+
         // Sleep time settings
         constexpr int SLEEP_TIME_MIN = 10;              // Min sleep time (us) 
         constexpr int SLEEP_TIME_MAX = 100;             // Max sleep time (us)
@@ -0,0 +1,73 @@
+#pragma once
+#include <sys/types.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "http_server_config.h"
+#include "peer_address.h"
+#include "tls.h"
+
+namespace httpserver {
+    enum class ListenerType {
+        TCP,            // IPv4, or IPv6 which is dual-stack unless v6Only is set
+        Unix            // AF_UNIX stream socket, a leading '@' selects the abstract namespace
+    };
+
+    struct ListenerConfig {
+        ListenerType type;
+        std::string address;            // Numeric host for TCP, socket path for Unix
+        std::uint16_t port;
+        int backlog;
+        bool v6Only;
+        bool noDelay;                   // TCP_NODELAY on accepted connections
+        int deferAcceptSeconds;         // TCP_DEFER_ACCEPT, 0 disables
+        int fastOpenQueue;              // TCP_FASTOPEN pending queue length, 0 disables
+        mode_t unixMode;                // Permissions applied to a filesystem socket, 0 keeps the umask
+        TlsConfig tls;                  // Connections are TLS when a certificate is set
+
+        static ListenerConfig Tcp(const std::string& host, std::uint16_t port);
+        static ListenerConfig Unix(const std::string& path);
+        static ListenerConfig Https(const std::string& host, std::uint16_t port, const TlsConfig& tls);
+
+    private:
+        ListenerConfig(ListenerType type, const std::string& address, std::uint16_t port);
+    };
+
+    // One listening socket. Accepted connections are non-blocking and carry the peer address,
+    // or for Unix sockets the peer's process id. TLS listeners load their context in Open.
+    class Listener {
+    public:
+        explicit Listener(const ListenerConfig& config);
+        ~Listener();
+
+        Listener(const Listener&) = delete;
+        Listener& operator=(const Listener&) = delete;
+
+        void Open();
+        void Close();
+
+        // Returns -1 when no connection is pending
+        int Accept(PeerAddress* peer);
+
+        const ListenerConfig& GetConfig() const;
+        int GetFd() const;
+        // Null unless the listener terminates TLS
+        TlsContext* GetTls() const;
+        // Port actually bound, differs from the config when it asked for port 0
+        std::uint16_t GetPort() const;
+        std::string Describe() const;
+
+    private:
+        ListenerConfig _config;
+        int _fd;
+        std::uint16_t _boundPort;
+        bool _ownsPath;                 // Set once bind created the socket file
+        std::unique_ptr<TlsContext> _tls;
+
+        void OpenTcp();
+        void OpenUnix();
+        void SetOption(int level, int option, int value, const char* name);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "http_server_config.h"
+
+namespace httpserver {
+    enum class PlacementPolicy {
+        RoundRobin,         // Strict rotation, ignores load
+        LeastConnections,   // Worker with the fewest open connections
+        PowerOfTwoChoices   // Less busy of two random workers, by recent busy time
+    };
+
+    struct LoadBalancerConfig {
+        PlacementPolicy policy;
+        bool rebalance;                 // Migrate idle keep-alive connections off overloaded workers
+        double imbalanceThreshold;      // Busiest worker load over the mean that triggers migration
+
+        explicit LoadBalancerConfig(PlacementPolicy policy = PlacementPolicy::RoundRobin, bool rebalance = false) :
+            policy(policy),
+            rebalance(rebalance),
+            imbalanceThreshold(1.25) {}
+    };
+
+    struct WorkerLoadStats {
+        std::int64_t connections;
+        std::uint64_t events;           // epoll events handled
+        double load;                    // Recent busy fraction in [0, 1]
+        std::uint64_t migratedIn;
+        std::uint64_t migratedOut;
+    };
+
+    // Places new connections on workers and tracks how busy each worker is. A monitor thread samples
+    // the workers' busy time every LOAD_SAMPLE_INTERVAL. With rebalancing on, it asks the busiest
+    // worker to hand over a few connections, which the worker does when they go idle between requests.
+    class LoadBalancer {
+    public:
+        explicit LoadBalancer(const LoadBalancerConfig& config);
+        ~LoadBalancer();
+
+        LoadBalancer(const LoadBalancer&) = delete;
+        LoadBalancer& operator=(const LoadBalancer&) = delete;
+
+        void Start();
+        void Stop();
+
+        // Called by the listener only
+        int PickWorker();
+
+        void AddConnection(int workerId);
+        void RemoveConnection(int workerId);
+        void MoveConnection(int fromWorker, int toWorker);
+
+        // Called by the owning worker only
+        void AddBusyTime(int workerId, std::uint64_t busyNs, std::uint32_t events);
+        // Worker an idle connection should move to, or -1 to keep it
+        int TakeMigration(int workerId);
+
+        const LoadBalancerConfig& GetConfig() const;
+        WorkerLoadStats GetStats(int workerId) const;
+        // Busiest worker's recent load over the mean, 1.0 is perfectly even
+        double GetImbalance() const;
+
+    private:
+        // Padded so that workers never share a cache line
+        struct WorkerState {
+            std::atomic<std::int64_t> connections;
+            std::atomic<std::uint64_t> events;
+            std::atomic<std::uint64_t> busyNs;
+            std::atomic<std::uint32_t> loadPpm;             // Published by the monitor
+            std::atomic<int> migrationTarget;
+            std::atomic<int> migrationBudget;
+            std::atomic<std::uint64_t> migratedIn;
+            std::atomic<std::uint64_t> migratedOut;
+            char padding[64];
+        };
+
+        LoadBalancerConfig _config;
+        std::unique_ptr<WorkerState> _workers[config::WORKER_POOL_SIZE];
+        std::atomic<std::uint32_t> _imbalancePpm;
+        std::atomic<bool> _running;
+        std::thread _monitorThread;
+
+        // Listener only
+        int _nextWorker;
+        std::uint64_t _randomState;
+
+        // Monitor only
+        std::uint64_t _previousBusyNs[config::WORKER_POOL_SIZE];
+        double _load[config::WORKER_POOL_SIZE];
+        int _cooldown;
+
+        void Run();
+        void Sample(std::uint64_t elapsedNs);
+        void Rebalance();
+    };
+}
\ No newline at end of file
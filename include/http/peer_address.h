@@ -0,0 +1,22 @@
+#pragma once
+#include <sys/socket.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace httpserver {
+    // Compact copy of a client address, small enough to travel with every connection
+    struct PeerAddress {
+        std::uint8_t family;            // AF_INET, AF_INET6, AF_UNIX or AF_UNSPEC
+        std::uint16_t port;             // Host byte order
+        std::uint8_t address[16];       // IPv4 uses the first 4 bytes, Unix the peer's process id
+
+        PeerAddress();
+
+        static PeerAddress FromSockaddr(const sockaddr* address, socklen_t length);
+
+        // Writes the textual address (no port) and returns its length, "unix:<pid>" for Unix peers
+        // and "-" when unknown
+        size_t Format(char* buffer, size_t size) const;
+    };
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <sys/types.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace httpserver {
+    // Snapshot of one worker process slot. Counters survive restarts of the process in the slot.
+    struct ProcessStats {
+        pid_t pid;                      // 0 while the slot waits for a restart
+        std::uint64_t restarts;
+        std::uint64_t accepted;
+        std::int64_t active;            // Open connections
+        std::uint64_t requests;
+        std::uint64_t responses[5];     // By status class, 1xx to 5xx
+        std::uint64_t bytesSent;
+    };
+
+    // Counters shared by the prefork master and its worker processes. The segment is an anonymous
+    // shared mapping created before the first fork, so every process sees the same pages. Each slot
+    // has a single writing process and all counters are lock-free atomics, nobody ever waits.
+    class ProcessStatsSegment {
+    public:
+        explicit ProcessStatsSegment(int processes);
+        ~ProcessStatsSegment();
+
+        ProcessStatsSegment(const ProcessStatsSegment&) = delete;
+        ProcessStatsSegment& operator=(const ProcessStatsSegment&) = delete;
+
+        int GetProcessCount() const;
+
+        // Called by the worker process in slot only
+        void AddConnection(int slot);
+        void RemoveConnection(int slot);
+        void AddRequest(int slot, int status, size_t bytes);
+
+        // Called by the master only, while no process runs in slot
+        void SetPid(int slot, pid_t pid);
+        void AddRestart(int slot);
+        void MarkExited(int slot);
+
+        ProcessStats GetStats(int slot) const;
+        // One line with the totals, then one line per slot
+        std::string Format() const;
+
+    private:
+        // Padded so that processes never share a cache line
+        struct alignas(64) Slot {
+            std::atomic<std::int64_t> pid;
+            std::atomic<std::uint64_t> restarts;
+            std::atomic<std::uint64_t> accepted;
+            std::atomic<std::int64_t> active;
+            std::atomic<std::uint64_t> requests;
+            std::atomic<std::uint64_t> responses[5];
+            std::atomic<std::uint64_t> bytesSent;
+        };
+
+        int _processes;
+        size_t _size;
+        Slot* _slots;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "http_server_config.h"
+#include "peer_address.h"
+#include "../utils/string_view.h"
+
+namespace httpserver {
+    enum class RateLimitMode {
+        Request,        // Checked by the worker for every request, rejected with a 429 response
+        Accept          // Checked by the listener for every connection, before anything is read
+    };
+
+    enum class RateLimitKey {
+        ClientAddress,  // Client address masked to a prefix
+        Header          // Value of a request header, falls back to the client address when missing
+    };
+
+    struct RateLimitConfig {
+        double requestsPerSecond;
+        double burst;
+        RateLimitMode mode;
+        RateLimitKey key;
+        std::string header;
+        int ipv4PrefixLength;
+        int ipv6PrefixLength;
+
+        RateLimitConfig(double requestsPerSecond, double burst) :
+            requestsPerSecond(requestsPerSecond),
+            burst(burst),
+            mode(RateLimitMode::Request),
+            key(RateLimitKey::ClientAddress),
+            header(),
+            ipv4PrefixLength(32),
+            ipv6PrefixLength(64) {}
+    };
+
+    // Token buckets sharded per worker (plus one shard for the listener) so the hot path never
+    // takes a lock. Every shard refills at the full rate, and a background thread periodically
+    // charges each shard with what the other shards consumed for the same key, keeping the limit
+    // global to within one reconciliation interval. A key seen for the first time on a shard starts
+    // with a full burst there, so a client spread over every worker may exceed its burst once.
+    class RateLimiter {
+    public:
+        static constexpr int LISTENER_SHARD = config::WORKER_POOL_SIZE;
+        static constexpr int SHARD_COUNT = config::WORKER_POOL_SIZE + 1;
+
+        explicit RateLimiter(const RateLimitConfig& config);
+        ~RateLimiter();
+
+        RateLimiter(const RateLimiter&) = delete;
+        RateLimiter& operator=(const RateLimiter&) = delete;
+
+        void Start();
+        void Stop();
+
+        // Called by the shard owner only, returns false when the request must be rejected
+        bool Allow(int shard, std::uint64_t key);
+
+        std::uint64_t KeyFor(const PeerAddress& peer) const;
+        std::uint64_t KeyFor(StringView value) const;
+
+        const RateLimitConfig& GetConfig() const;
+        // Pre-serialized 429 response with Retry-After
+        StringView GetRejection() const;
+        std::uint64_t GetRejectedCount() const;
+
+    private:
+        struct Bucket {
+            std::atomic<std::uint64_t> key;         // 0 marks an empty slot
+            std::atomic<std::uint64_t> consumed;    // Tokens taken by the owning shard
+            std::atomic<std::uint64_t> foreign;     // Tokens taken by other shards, only grows
+            std::uint64_t appliedForeign;           // Owner only
+            double tokens;                          // Owner only
+            std::int64_t lastRefill;                // Owner only, nanoseconds
+        };
+
+        struct Shard {
+            std::unique_ptr<Bucket[]> buckets;
+            std::atomic<std::uint64_t> rejected;
+            char padding[64 - sizeof(std::unique_ptr<Bucket[]>) - sizeof(std::atomic<std::uint64_t>)];
+        };
+
+        RateLimitConfig _config;
+        std::string _rejection;
+        Shard _shards[SHARD_COUNT];
+
+        std::atomic<bool> _running;
+        std::thread _reconcilerThread;
+        // Reconciler state per bucket slot across all shards
+        std::vector<std::uint64_t> _previousKeys;
+        std::vector<std::uint64_t> _previousConsumed;
+        std::vector<std::uint64_t> _deltas;
+
+        Bucket& FindBucket(Shard& shard, std::uint64_t key, std::int64_t now);
+        void Reconcile();
+        void Run();
+    };
+}
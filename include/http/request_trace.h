@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "http_server_config.h"
+#include "../utils/spsc_ring.h"
+
+namespace httpserver {
+    // Phase i of a request runs from mark i to mark i + 1
+    enum class TracePhase : std::uint8_t {
+        Queue,          // epoll_wait returned until the request was read
+        Parse,          // FromString
+        Handle,         // Routing and the user handler
+        Serialize,      // ToBuffer
+        Send            // First send until the last byte was written, including retries
+    };
+
+    constexpr int TRACE_PHASE_COUNT = 5;
+
+    // Finished request as stored in the rings, durations are already converted to nanoseconds
+    struct RequestTraceRecord {
+        std::uint64_t startNs;          // Since the tracer was created
+        std::uint32_t phaseNs[TRACE_PHASE_COUNT];
+        std::uint32_t totalNs;
+        std::uint16_t status;
+        std::uint16_t sendCalls;
+        std::uint8_t method;            // HttpMethod, or METHOD_UNKNOWN when parsing failed
+        std::uint8_t workerId;
+        std::uint8_t pathLength;
+        char path[config::TRACE_PATH_SIZE];
+
+        static constexpr std::uint8_t METHOD_UNKNOWN = 0xFF;
+    };
+
+    // In-flight state of a sampled request, kept in its response buffer until the send completes
+    struct RequestTrace {
+        std::uint64_t marks[TRACE_PHASE_COUNT + 1];     // RequestTracer::Now ticks
+        RequestTraceRecord record;
+    };
+
+    // Workers sample requests into their own SPSC ring and update per-phase histograms in place.
+    // Reports drain the rings under a lock, so any thread may ask for them.
+    class RequestTracer {
+    public:
+        explicit RequestTracer(double sampleRate);
+
+        RequestTracer(const RequestTracer&) = delete;
+        RequestTracer& operator=(const RequestTracer&) = delete;
+
+        // TSC ticks on x86, CLOCK_MONOTONIC_COARSE nanoseconds elsewhere
+        static std::uint64_t Now();
+
+        // Called from the owning worker only
+        bool ShouldSample(int workerId);
+        void Record(int workerId, RequestTrace& trace);
+
+        // Histograms and the slowest requests as plain text, or as Chrome trace-event JSON
+        std::string FormatSummary();
+        std::string FormatChromeTrace();
+
+        std::uint64_t GetSampledCount() const;
+        std::uint64_t GetDroppedCount() const;
+
+    private:
+        using Ring = SpscRing<RequestTraceRecord, config::TRACE_RING_SIZE>;
+        using Histogram = std::atomic<std::uint64_t>[TRACE_PHASE_COUNT][config::TRACE_HISTOGRAM_BUCKETS];
+
+        struct WorkerState {
+            std::uint64_t randomState;
+            std::atomic<std::uint64_t> sampled;
+            std::atomic<std::uint64_t> dropped;
+            Histogram histogram;
+        };
+
+        double _sampleRate;
+        std::uint64_t _threshold;
+        std::uint64_t _epoch;
+        double _nanosecondsPerTick;
+
+        std::unique_ptr<Ring> _rings[config::WORKER_POOL_SIZE];
+        std::unique_ptr<WorkerState> _workers[config::WORKER_POOL_SIZE];
+
+        // Guards draining and the slowest requests seen so far, a min-heap on totalNs
+        std::mutex _mutex;
+        std::vector<RequestTraceRecord> _slowest;
+
+        std::uint64_t ToNanoseconds(std::uint64_t ticks) const;
+        void Drain();
+        std::vector<RequestTraceRecord> SortedSlowest();
+        void MergeHistograms(std::uint64_t counts[TRACE_PHASE_COUNT][config::TRACE_HISTOGRAM_BUCKETS]) const;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+#include <sys/types.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+struct ssl_ctx_st;
+struct ssl_st;
+
+namespace httpserver {
+    struct TlsConfig {
+        std::string certificateFile;    // PEM, may hold the whole chain
+        std::string privateKeyFile;     // PEM
+        bool sessionTickets;            // Stateless resumption, the ticket keys live as long as the listener
+        bool kernelTls;                 // Hand the record layer to the kernel after the handshake when possible
+
+        TlsConfig() : sessionTickets(true), kernelTls(true) {}
+        TlsConfig(const std::string& certificateFile, const std::string& privateKeyFile) :
+            certificateFile(certificateFile),
+            privateKeyFile(privateKeyFile),
+            sessionTickets(true),
+            kernelTls(true) {}
+    };
+
+    struct TlsStats {
+        std::uint64_t handshakes;       // Completed, including resumed ones
+        std::uint64_t resumed;
+        std::uint64_t failed;
+        std::uint64_t kernelSend;       // Connections whose record layer moved to the kernel
+        std::uint64_t kernelReceive;
+    };
+
+    // Server side OpenSSL context shared by every connection of one listener. Contexts are created
+    // before workers start or fork, so all workers and processes decrypt each other's tickets.
+    class TlsContext {
+    public:
+        explicit TlsContext(const TlsConfig& config);
+        ~TlsContext();
+
+        TlsContext(const TlsContext&) = delete;
+        TlsContext& operator=(const TlsContext&) = delete;
+
+        const TlsConfig& GetConfig() const;
+        TlsStats GetStats() const;
+
+    private:
+        friend class TlsSession;
+
+        TlsConfig _config;
+        ssl_ctx_st* _context;
+        std::atomic<std::uint64_t> _handshakes;
+        std::atomic<std::uint64_t> _resumed;
+        std::atomic<std::uint64_t> _failed;
+        std::atomic<std::uint64_t> _kernelSend;
+        std::atomic<std::uint64_t> _kernelReceive;
+    };
+
+    enum class TlsHandshakeStatus {
+        Done,
+        WantRead,
+        WantWrite,
+        Failed
+    };
+
+    // TLS state of one non-blocking connection. Read and Write behave like recv and send: they
+    // return -1 with errno set to EAGAIN when the socket is not ready, so callers keep their
+    // EPOLLIN/EPOLLOUT handling. Once the kernel owns the record layer they only forward to it.
+    class TlsSession {
+    public:
+        TlsSession(TlsContext& context, int fd);
+        ~TlsSession();
+
+        TlsSession(const TlsSession&) = delete;
+        TlsSession& operator=(const TlsSession&) = delete;
+
+        TlsHandshakeStatus Handshake();
+        bool IsEstablished() const;
+
+        ssize_t Read(char* buffer, size_t length);
+        // Retries after EAGAIN must pass the same remaining bytes again
+        ssize_t Write(const char* buffer, size_t length);
+        // Decrypted bytes buffered in userspace, not signalled by epoll
+        bool HasPending() const;
+
+        bool IsResumed() const;
+        // Plain send and sendmsg on the socket produce TLS records
+        bool IsKernelSend() const;
+        bool IsKernelReceive() const;
+
+    private:
+        TlsContext& _context;
+        ssl_st* _ssl;
+        bool _established;
+        bool _failed;                   // OpenSSL forbids a shutdown after a fatal error
+        bool _kernelSend;
+        bool _kernelReceive;
+
+        ssize_t Fail(int result);
+    };
+}
\ No newline at end of file
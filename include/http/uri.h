@@ -12,10 +12,10 @@ namespace httpserver {
         bool operator==(const URI& other) const;
         bool operator<(const URI& other) const;
 
-        void Parse(std::string uri);
+        void Parse(const std::string& uri);
 
-        std::string GetPath() const;
-        std::string GetQuery() const;
+        const std::string& GetPath() const;
+        const std::string& GetQuery() const;
 
         bool IsValid() const;
 
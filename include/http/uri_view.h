@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "http_server_config.h"
+#include "../utils/arena.h"
+#include "../utils/string_view.h"
+
+namespace httpserver {
+    // Zero-copy view over a request-target inside the request buffer, the buffer must outlive the view.
+    // Path normalization, percent-decoding and query indexing only run when first requested.
+    class URIView {
+    public:
+        URIView();
+        URIView(const char* data, size_t length);
+        ~URIView() = default;
+
+        void Parse(const char* data, size_t length);
+
+        StringView GetRaw() const;
+        StringView GetRawPath() const;
+        StringView GetRawQuery() const;
+
+        // Percent-decoded path with dot segments removed, views the raw path when nothing changes
+        StringView GetPath() const;
+
+        // Lookup by decoded key, the value stays percent-encoded and no allocation is made
+        bool FindQueryParam(StringView key, StringView* value) const;
+        // Lookup by decoded key, returns the decoded value or an empty string
+        std::string GetQueryParam(StringView key) const;
+        bool HasQueryParam(StringView key) const;
+        size_t GetQueryParamCount() const;
+
+        bool IsValid() const;
+
+        static std::string PercentDecode(StringView input, bool plusAsSpace);
+
+    private:
+        // Offsets into the raw query. Parse accepts targets of any length, not only ones bounded by
+        // MAX_BUFFER_SIZE, so they take 32 bits and targets past 4 GiB are not indexed at all.
+        struct QueryParam {
+            std::uint32_t keyOffset;
+            std::uint32_t keyLength;
+            std::uint32_t valueOffset;
+            std::uint32_t valueLength;
+        };
+
+        StringView _raw;
+        StringView _path;
+        StringView _query;
+
+        mutable bool _pathNormalized;
+        mutable bool _queryIndexed;
+        mutable bool _queryOverflow;
+        mutable size_t _queryParamCount;
+        mutable size_t _queryIndexEnd;
+        mutable ArenaString _normalizedPath;
+        mutable QueryParam _queryParams[config::MAX_QUERY_PARAMS];
+
+        void NormalizePath() const;
+        void IndexQuery() const;
+        bool ScanQuery(size_t from, StringView key, StringView* value) const;
+    };
+}
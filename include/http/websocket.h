@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "http_server_config.h"
+#include "peer_address.h"
+#include "tls.h"
+#include "../utils/string_view.h"
+
+namespace httpserver {
+    enum class WebSocketOpcode : std::uint8_t {
+        Continuation = 0x0,
+        Text = 0x1,
+        Binary = 0x2,
+        Close = 0x8,
+        Ping = 0x9,
+        Pong = 0xA
+    };
+
+    struct WebSocketFrameHeader {
+        bool fin;
+        bool reserved;                  // Any RSV bit set, no extensions are negotiated
+        WebSocketOpcode opcode;
+        bool masked;
+        std::uint8_t maskKey[4];
+        std::uint64_t payloadLength;
+    };
+
+    // Serialized frame shared by every recipient, server frames are unmasked so the bytes are identical
+    using WebSocketFrame = std::shared_ptr<const std::string>;
+
+    // Returns the header size, or 0 when more bytes are needed
+    size_t ParseWebSocketFrameHeader(const char* data, size_t length, WebSocketFrameHeader* header);
+    WebSocketFrame MakeWebSocketFrame(WebSocketOpcode opcode, StringView payload);
+    // XORs data with the mask key, offset is the position of data[0] within the payload
+    void ApplyWebSocketMask(char* data, size_t length, const std::uint8_t maskKey[4], size_t offset = 0);
+    std::string ComputeWebSocketAccept(StringView key);
+
+    class WebSocketConnection;
+
+    // Callbacks run on the worker that owns the connection
+    struct WebSocketHandler {
+        std::function<void(WebSocketConnection&)> onOpen;
+        std::function<void(WebSocketConnection&, WebSocketOpcode, StringView)> onMessage;
+        std::function<void(WebSocketConnection&, std::uint16_t)> onClose;
+    };
+
+    class WebSocketConnection {
+    public:
+        WebSocketConnection(int fd, int epollFd, void* eventData, const WebSocketHandler* handler,
+                            const std::string& path, const PeerAddress& peer, TlsSession* tls = nullptr);
+        ~WebSocketConnection();
+
+        WebSocketConnection(const WebSocketConnection&) = delete;
+        WebSocketConnection& operator=(const WebSocketConnection&) = delete;
+
+        // Only call from the owning worker, e.g. inside the handler callbacks
+        void SendText(StringView message);
+        void SendBinary(StringView message);
+        void Send(const WebSocketFrame& frame);
+        void Close(std::uint16_t code = 1000, StringView reason = StringView());
+
+        const std::string& GetPath() const;
+        const PeerAddress& GetPeer() const;
+        bool IsClosing() const;
+
+        // Event loop entry points, the owner tears the connection down once ShouldClose is true
+        void Open();
+        void OnReadable();
+        void OnWritable();
+        bool ShouldClose() const;
+
+    private:
+        struct PendingFrame {
+            WebSocketFrame frame;
+            size_t offset;
+        };
+
+        int _fd;
+        int _epollFd;
+        void* _eventData;
+        TlsSession* _tls;               // Null for plain connections, freed along with the connection
+        const WebSocketHandler* _handler;
+        std::string _path;
+        PeerAddress _peer;
+
+        std::vector<char> _readBuffer;
+        size_t _readLength;
+        std::string _message;
+        WebSocketOpcode _messageOpcode;
+        bool _inMessage;
+
+        std::deque<PendingFrame> _queue;
+        size_t _queuedBytes;
+        bool _wantWrite;
+
+        bool _opened;
+        bool _closeSent;
+        bool _broken;
+        std::uint16_t _closeCode;
+
+        void HandleFrame(const WebSocketFrameHeader& header, char* payload, size_t length);
+        void Deliver(WebSocketOpcode opcode, StringView payload);
+        void Fail(std::uint16_t code);
+        void SendClose(StringView payload);
+        void Enqueue(const WebSocketFrame& frame);
+        void Flush();
+        void FlushTls();
+        void UpdateInterest(bool wantWrite);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <new>
+#include <string>
+#include <type_traits>
+
+#include "../http/http_server_config.h"
+
+namespace httpserver {
+    // Monotonic bump allocator reset after every response. Deallocation is a no-op, memory is
+    // reclaimed all at once by Reset(). Overflow blocks are merged into one larger block on reset,
+    // so a steady workload stops calling malloc after warming up.
+    class Arena {
+    public:
+        explicit Arena(size_t blockSize = config::ARENA_BLOCK_SIZE);
+        ~Arena();
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+        void Reset();
+
+        size_t GetBytesUsed() const;
+        size_t GetCapacity() const;
+
+        // Arena used by default-constructed ArenaAllocators on this thread, null outside a request
+        static Arena* Current();
+
+        // Makes an arena current for the lifetime of the scope
+        class Scope {
+        public:
+            explicit Scope(Arena& arena);
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            Arena* _previous;
+        };
+
+    private:
+        struct Block {
+            Block* next;
+            size_t size;
+        };
+
+        Block* _blocks;
+        char* _cursor;
+        char* _end;
+        size_t _blockSize;
+        size_t _bytesUsed;
+        size_t _capacity;
+
+        void AddBlock(size_t minimumSize);
+        void FreeBlocks();
+    };
+
+    // Standard allocator over an Arena. A default-constructed allocator binds to Arena::Current()
+    // and falls back to the global heap when no arena is current.
+    template <typename T>
+    class ArenaAllocator {
+    public:
+        using value_type = T;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        ArenaAllocator() : _arena(Arena::Current()) {}
+        explicit ArenaAllocator(Arena* arena) : _arena(arena) {}
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) : _arena(other.GetArena()) {}
+
+        T* allocate(size_t count) {
+            if (_arena) {
+                return static_cast<T*>(_arena->Allocate(count * sizeof(T), alignof(T)));
+            }
+            return static_cast<T*>(::operator new(count * sizeof(T)));
+        }
+
+        void deallocate(T* pointer, size_t) {
+            if (!_arena) {
+                ::operator delete(pointer);
+            }
+        }
+
+        Arena* GetArena() const { return _arena; }
+
+    private:
+        Arena* _arena;
+    };
+
+    template <typename T, typename U>
+    bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {
+        return lhs.GetArena() == rhs.GetArena();
+    }
+
+    template <typename T, typename U>
+    bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {
+        return !(lhs == rhs);
+    }
+
+    using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+    template <typename Key, typename Value>
+    using ArenaMap = std::map<Key, Value, std::less<>, ArenaAllocator<std::pair<const Key, Value>>>;
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace httpserver {
+    std::string Base64Encode(const void* data, size_t length);
+}
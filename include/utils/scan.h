@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+
+namespace httpserver {
+    namespace scan {
+        enum class Isa {
+            Scalar,
+            SSE42,
+            AVX2
+        };
+
+        // Every kernel scans [begin, end) and returns end when nothing is found
+        struct Kernels {
+            const char* (*findChar)(const char* begin, const char* end, char c);
+            const char* (*findCRLF)(const char* begin, const char* end);
+            const char* (*findNonToken)(const char* begin, const char* end);
+            const char* (*findNonFieldValue)(const char* begin, const char* end);
+        };
+
+        Isa DetectIsa();
+        const char* GetIsaName(Isa isa);
+        // Unsupported instruction sets fall back to the scalar kernels
+        const Kernels& GetKernels(Isa isa);
+        const Kernels& ActiveKernels();
+        // Overrides runtime dispatch, not safe to call while the server is running
+        void SelectIsa(Isa isa);
+
+        inline const char* FindChar(const char* begin, const char* end, char c) {
+            return ActiveKernels().findChar(begin, end, c);
+        }
+
+        inline const char* FindCRLF(const char* begin, const char* end) {
+            return ActiveKernels().findCRLF(begin, end);
+        }
+
+        // First byte that is not an RFC 7230 tchar
+        inline const char* FindNonToken(const char* begin, const char* end) {
+            return ActiveKernels().findNonToken(begin, end);
+        }
+
+        // First control byte other than HTAB, obs-text bytes are accepted
+        inline const char* FindNonFieldValue(const char* begin, const char* end) {
+            return ActiveKernels().findNonFieldValue(begin, end);
+        }
+
+        // Optional whitespace only surrounds a field value, so trimming stays scalar
+        inline void TrimWhitespace(const char*& begin, const char*& end) {
+            while (begin < end && (*begin == ' ' || *begin == '\t')) ++begin;
+            while (end > begin && (end[-1] == ' ' || end[-1] == '\t')) --end;
+        }
+    }
+}
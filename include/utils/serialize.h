@@ -15,6 +15,14 @@ namespace httpserver {
 template <typename T>
 std::string ToString(T value);
 
+// Parsed requests reference the input string through their URI view, it must outlive the result
 template <typename T>
 T FromString(const std::string& str);
 
+template <typename T>
+T FromString(const char* data, size_t length);
+
+// Serializes into a caller-owned buffer and returns the bytes written, output is truncated to size
+template <typename T>
+size_t ToBuffer(const T& value, char* buffer, size_t size);
+
@@ -0,0 +1,10 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace httpserver {
+    constexpr size_t SHA1_DIGEST_SIZE = 20;
+
+    // Only used for the WebSocket handshake, not for anything security sensitive
+    void Sha1(const void* data, size_t length, std::uint8_t digest[SHA1_DIGEST_SIZE]);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+namespace httpserver {
+    // Bounded single-producer/single-consumer queue, never blocks on either side.
+    // Producer and consumer indices live on separate cache lines to avoid false sharing.
+    template <typename T, size_t Capacity>
+    class SpscRing {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        SpscRing() : _head(0), _cachedTail(0), _tail(0), _cachedHead(0) {}
+
+        SpscRing(const SpscRing&) = delete;
+        SpscRing& operator=(const SpscRing&) = delete;
+
+        // Producer side, returns false when the ring is full
+        bool TryPush(const T& item) {
+            size_t head = _head.load(std::memory_order_relaxed);
+            if (head - _cachedTail == Capacity) {
+                _cachedTail = _tail.load(std::memory_order_acquire);
+                if (head - _cachedTail == Capacity) {
+                    return false;
+                }
+            }
+            _items[head & (Capacity - 1)] = item;
+            _head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side, returns false when the ring is empty
+        bool TryPop(T* item) {
+            size_t tail = _tail.load(std::memory_order_relaxed);
+            if (tail == _cachedHead) {
+                _cachedHead = _head.load(std::memory_order_acquire);
+                if (tail == _cachedHead) {
+                    return false;
+                }
+            }
+            *item = _items[tail & (Capacity - 1)];
+            _tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool Empty() const {
+            return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+        }
+
+    private:
+        static constexpr size_t CACHE_LINE_SIZE = 64;
+
+        std::atomic<size_t> _head;
+        size_t _cachedTail;
+        char _producerPadding[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+        std::atomic<size_t> _tail;
+        size_t _cachedHead;
+        char _consumerPadding[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+        T _items[Capacity];
+    };
+}
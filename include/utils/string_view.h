@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace httpserver {
+    // Non-owning reference to a character range, the referenced buffer must outlive the view
+    class StringView {
+    public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        StringView() : _data(nullptr), _length(0) {}
+        StringView(const char* data, size_t length) : _data(data), _length(length) {}
+        StringView(const char* str) : _data(str), _length(std::strlen(str)) {}
+        template <typename Allocator>
+        StringView(const std::basic_string<char, std::char_traits<char>, Allocator>& str) :
+            _data(str.data()), _length(str.length()) {}
+
+        const char* Data() const { return _data; }
+        size_t Length() const { return _length; }
+        bool Empty() const { return _length == 0; }
+        char operator[](size_t pos) const { return _data[pos]; }
+        const char* begin() const { return _data; }
+        const char* end() const { return _data + _length; }
+
+        StringView Substr(size_t pos, size_t length = npos) const {
+            if (pos > _length) pos = _length;
+            if (length > _length - pos) length = _length - pos;
+            return StringView(_data + pos, length);
+        }
+
+        size_t Find(char c, size_t pos = 0) const {
+            if (pos >= _length) return npos;
+            const void* found = std::memchr(_data + pos, c, _length - pos);
+            return found ? static_cast<const char*>(found) - _data : npos;
+        }
+
+        std::string ToString() const { return std::string(_data, _length); }
+
+        int Compare(StringView other) const {
+            size_t length = _length < other._length ? _length : other._length;
+            int result = length ? std::memcmp(_data, other._data, length) : 0;
+            if (result != 0) return result;
+            return _length < other._length ? -1 : (_length > other._length ? 1 : 0);
+        }
+
+    private:
+        const char* _data;
+        size_t _length;
+    };
+
+    // Comparisons also cover std::basic_string so string-keyed maps can be searched with std::less<>
+    inline bool operator==(StringView lhs, StringView rhs) {
+        return lhs.Length() == rhs.Length() && lhs.Compare(rhs) == 0;
+    }
+    inline bool operator!=(StringView lhs, StringView rhs) { return !(lhs == rhs); }
+    inline bool operator<(StringView lhs, StringView rhs) { return lhs.Compare(rhs) < 0; }
+
+    template <typename Allocator>
+    bool operator<(const std::basic_string<char, std::char_traits<char>, Allocator>& lhs, StringView rhs) {
+        return StringView(lhs).Compare(rhs) < 0;
+    }
+
+    template <typename Allocator>
+    bool operator<(StringView lhs, const std::basic_string<char, std::char_traits<char>, Allocator>& rhs) {
+        return lhs.Compare(StringView(rhs)) < 0;
+    }
+}
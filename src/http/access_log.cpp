@@ -0,0 +1,324 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+#include "../../include/http/access_log.h"
+#include "../../include/http/http_message.h"
+
+namespace httpserver {
+
+    namespace {
+        // Formatted lines are bounded by the record size (escaping at most sextuples a byte)
+        constexpr size_t MAX_LINE_SIZE = 256 + 6 * (config::ACCESS_LOG_PATH_SIZE + 2 * config::ACCESS_LOG_FIELD_SIZE);
+        constexpr std::uint64_t ALWAYS_SAMPLE = std::uint64_t(1) << 32;
+
+        std::uint64_t RateToThreshold(double rate) {
+            if (rate <= 0.0) return 0;
+            if (rate >= 1.0) return ALWAYS_SAMPLE;
+            return static_cast<std::uint64_t>(rate * static_cast<double>(ALWAYS_SAMPLE));
+        }
+
+        const char* MethodName(std::uint8_t method) {
+            switch (static_cast<HttpMethod>(method)) {
+                case HttpMethod::GET: return "GET";
+                case HttpMethod::HEAD: return "HEAD";
+                case HttpMethod::POST: return "POST";
+                case HttpMethod::PUT: return "PUT";
+                case HttpMethod::DELETE: return "DELETE";
+                case HttpMethod::CONNECT: return "CONNECT";
+                case HttpMethod::OPTIONS: return "OPTIONS";
+                case HttpMethod::TRACE: return "TRACE";
+                case HttpMethod::PATCH: return "PATCH";
+                default: return "-";
+            }
+        }
+    }
+
+    AccessLog::AccessLog(const std::string& path, AccessLogFormat format) :
+        _path(path),
+        _format(format),
+        _fd(-1),
+        _running(false),
+        _reopenRequested(false),
+        _written(0),
+        _defaultThreshold(ALWAYS_SAMPLE),
+        _bufferLength(0),
+        _cachedSecond(-1),
+        _cachedTime(),
+        _cachedTimeLength(0) {
+        for (int i = 0; i < config::WORKER_POOL_SIZE; ++i) {
+            _rings[i].reset(new Ring());
+            _workers[i].dropped = 0;
+            _workers[i].randomState = 0x9E3779B97F4A7C15ULL * (i + 1);
+        }
+        _buffer.reset(new char[config::ACCESS_LOG_BUFFER_SIZE]);
+    }
+
+    AccessLog::~AccessLog() {
+        Stop();
+    }
+
+    void AccessLog::SetSampleRate(const std::string& route, double rate) {
+        std::string key = route;
+        if (key.empty() || key[0] != '/') {
+            key = "/" + key;
+        }
+        _routeThresholds[key] = RateToThreshold(rate);
+    }
+
+    void AccessLog::SetDefaultSampleRate(double rate) {
+        _defaultThreshold = RateToThreshold(rate);
+    }
+
+    void AccessLog::Start() {
+        OpenFile();
+        _running = true;
+        _writerThread = std::thread(&AccessLog::Run, this);
+    }
+
+    void AccessLog::Stop() {
+        _running = false;
+        if (_writerThread.joinable()) {
+            _writerThread.join();
+        }
+        if (_fd >= 0) {
+            close(_fd);
+            _fd = -1;
+        }
+    }
+
+    bool AccessLog::ShouldSample(int workerId, StringView route) {
+        auto it = _routeThresholds.find(route);
+        std::uint64_t threshold = it != _routeThresholds.end() ? it->second : _defaultThreshold;
+        if (threshold >= ALWAYS_SAMPLE) return true;
+        if (threshold == 0) return false;
+
+        // xorshift64, state is private to the worker
+        std::uint64_t& state = _workers[workerId].randomState;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return (state >> 32) < threshold;
+    }
+
+    void AccessLog::Push(int workerId, const AccessLogRecord& record) {
+        if (!_rings[workerId]->TryPush(record)) {
+            _workers[workerId].dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void AccessLog::Reopen() {
+        _reopenRequested = true;
+    }
+
+    std::uint64_t AccessLog::GetDroppedCount() const {
+        std::uint64_t dropped = 0;
+        for (int i = 0; i < config::WORKER_POOL_SIZE; ++i) {
+            dropped += _workers[i].dropped.load(std::memory_order_relaxed);
+        }
+        return dropped;
+    }
+
+    std::uint64_t AccessLog::GetWrittenCount() const {
+        return _written.load(std::memory_order_relaxed);
+    }
+
+    void AccessLog::OpenFile() {
+        int fd = open(_path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open access log " + _path);
+        }
+        if (_fd >= 0) {
+            close(_fd);
+        }
+        _fd = fd;
+    }
+
+    void AccessLog::Run() {
+        AccessLogRecord record;
+        bool draining = false;
+
+        // Keep draining after Stop() until every ring is empty
+        while (_running || !draining) {
+            if (!_running) {
+                draining = true;
+            }
+
+            size_t formatted = 0;
+            for (int i = 0; i < config::WORKER_POOL_SIZE; ++i) {
+                for (size_t n = 0; n < config::ACCESS_LOG_BATCH_SIZE && _rings[i]->TryPop(&record); ++n) {
+                    if (_bufferLength + MAX_LINE_SIZE > config::ACCESS_LOG_BUFFER_SIZE) {
+                        Flush();
+                    }
+                    Format(record);
+                    ++formatted;
+                }
+            }
+            _written.fetch_add(formatted, std::memory_order_relaxed);
+
+            if (_reopenRequested.exchange(false)) {
+                Flush();
+                try {
+                    OpenFile();
+                } catch (const std::exception&) {
+                    // Keep writing to the previous file if the new one cannot be opened
+                }
+            }
+
+            if (formatted == 0) {
+                Flush();
+                if (_running) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(config::ACCESS_LOG_IDLE_SLEEP));
+                }
+            } else if (draining) {
+                draining = false;
+            }
+        }
+        Flush();
+    }
+
+    void AccessLog::Flush() {
+        size_t offset = 0;
+        while (offset < _bufferLength && _fd >= 0) {
+            ssize_t written = write(_fd, _buffer.get() + offset, _bufferLength - offset);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            offset += written;
+        }
+        _bufferLength = 0;
+    }
+
+    void AccessLog::FormatTime(std::int64_t timestampUs) {
+        std::int64_t second = timestampUs / 1000000;
+        if (second == _cachedSecond) {
+            return;
+        }
+
+        std::time_t time = static_cast<std::time_t>(second);
+        std::tm utc;
+        gmtime_r(&time, &utc);
+        const char* pattern = _format == AccessLogFormat::JsonLines ? "%Y-%m-%dT%H:%M:%S" : "%d/%b/%Y:%H:%M:%S +0000";
+        _cachedTimeLength = std::strftime(_cachedTime, sizeof(_cachedTime), pattern, &utc);
+        _cachedSecond = second;
+    }
+
+    void AccessLog::Append(const char* data, size_t length) {
+        std::memcpy(_buffer.get() + _bufferLength, data, length);
+        _bufferLength += length;
+    }
+
+    void AccessLog::AppendEscaped(const char* data, size_t length, bool json) {
+        static const char kHex[] = "0123456789abcdef";
+        char* out = _buffer.get() + _bufferLength;
+        for (size_t i = 0; i < length; ++i) {
+            unsigned char c = static_cast<unsigned char>(data[i]);
+            if (c == '"' || c == '\\') {
+                *out++ = '\\';
+                *out++ = static_cast<char>(c);
+            } else if (c < 0x20 || c == 0x7F || (json && c >= 0x80)) {
+                // JSON needs \u00XX, log formats conventionally use \xXX. Raw bytes from the request may
+                // not be valid UTF-8, so JSON escapes every non-ASCII byte to keep each line parseable.
+                *out++ = '\\';
+                if (json) {
+                    *out++ = 'u';
+                    *out++ = '0';
+                    *out++ = '0';
+                } else {
+                    *out++ = 'x';
+                }
+                *out++ = kHex[c >> 4];
+                *out++ = kHex[c & 15];
+            } else {
+                *out++ = static_cast<char>(c);
+            }
+        }
+        _bufferLength = out - _buffer.get();
+    }
+
+    void AccessLog::AppendNumber(std::uint64_t value) {
+        char digits[20];
+        size_t count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value);
+        while (count) {
+            _buffer[_bufferLength++] = digits[--count];
+        }
+    }
+
+    void AccessLog::Format(const AccessLogRecord& record) {
+        char peer[64];
+        size_t peerLength = record.peer.Format(peer, sizeof(peer));
+        const char* method = MethodName(record.method);
+        const char* version = record.method == AccessLogRecord::METHOD_UNKNOWN ? "-" : "HTTP/1.1";
+        FormatTime(record.timestampUs);
+
+        if (_format == AccessLogFormat::JsonLines) {
+            Append("{\"time\":\"", 9);
+            Append(_cachedTime, _cachedTimeLength);
+            char fraction[8] = {'.', '0', '0', '0', '0', '0', '0', 'Z'};
+            std::int64_t micros = record.timestampUs % 1000000;
+            for (int i = 6; i >= 1; --i, micros /= 10) {
+                fraction[i] = static_cast<char>('0' + micros % 10);
+            }
+            Append(fraction, sizeof(fraction));
+            Append("\",\"peer\":\"", 10);
+            Append(peer, peerLength);
+            Append("\",\"port\":", 9);
+            AppendNumber(record.peer.port);
+            Append(",\"method\":\"", 11);
+            Append(method, std::strlen(method));
+            Append("\",\"path\":\"", 10);
+            AppendEscaped(record.path, record.pathLength, true);
+            Append("\",\"status\":", 11);
+            AppendNumber(record.status);
+            Append(",\"bytes\":", 9);
+            AppendNumber(record.bytes);
+            Append(",\"latency_us\":", 14);
+            AppendNumber(record.latencyUs);
+            Append(",\"referer\":\"", 12);
+            AppendEscaped(record.referer, record.refererLength, true);
+            Append("\",\"user_agent\":\"", 16);
+            AppendEscaped(record.userAgent, record.userAgentLength, true);
+            Append("\"}\n", 3);
+            return;
+        }
+
+        // host ident authuser [date] "request" status bytes
+        Append(peer, peerLength);
+        Append(" - - [", 6);
+        Append(_cachedTime, _cachedTimeLength);
+        Append("] \"", 3);
+        Append(method, std::strlen(method));
+        Append(" ", 1);
+        if (record.pathLength) {
+            AppendEscaped(record.path, record.pathLength, false);
+        } else {
+            Append("-", 1);
+        }
+        Append(" ", 1);
+        Append(version, std::strlen(version));
+        Append("\" ", 2);
+        AppendNumber(record.status);
+        Append(" ", 1);
+        AppendNumber(record.bytes);
+
+        if (_format == AccessLogFormat::Combined) {
+            Append(" \"", 2);
+            AppendEscaped(record.refererLength ? record.referer : "-", record.refererLength ? record.refererLength : 1, false);
+            Append("\" \"", 3);
+            AppendEscaped(record.userAgentLength ? record.userAgent : "-", record.userAgentLength ? record.userAgentLength : 1, false);
+            Append("\"", 1);
+        }
+        Append("\n", 1);
+    }
+
+}
@@ -14,57 +14,144 @@ namespace httpserver {
 
     HttpMessage::HttpMessage() : _version(HttpVersion::HTTP_11) {}  // version is HTTP/1.1
 
-    void HttpMessage::SetHeader(const std::string& key, const std::string& value) {
-        if (!key.empty()) {
-            _headers[key] = value;
+    void HttpMessage::SetHeader(StringView key, StringView value) {
+        if (key.Empty()) {
+            return;
+        }
+        auto it = _headers.find(key);
+        if (it != _headers.end()) {
+            it->second.assign(value.Data(), value.Length());
+        } else {
+            auto allocator = _headers.get_allocator();
+            _headers.emplace(ArenaString(key.Data(), key.Length(), allocator),
+                             ArenaString(value.Data(), value.Length(), allocator));
         }
     }
 
-    void HttpMessage::RemoveHeader(const std::string& key) {
-        _headers.erase(key);
+    void HttpMessage::RemoveHeader(StringView key) {
+        auto it = _headers.find(key);
+        if (it != _headers.end()) {
+            _headers.erase(it);
+        }
     }
 
     void HttpMessage::ClearHeaders() {
         _headers.clear();
     }
 
-    void HttpMessage::SetContent(const std::string& content) {
-        _content = content;
-        SetHeader("Content-Length", std::to_string(_content.length()));
+    void HttpMessage::SetContent(StringView content) {
+        _content.assign(content.Data(), content.Length());
+        UpdateContentLength();
+    }
+
+    void HttpMessage::SetContent(const char* content) {
+        SetContent(StringView(content));
+    }
+
+    void HttpMessage::SetContent(ArenaString&& content) {
+        _content = std::move(content);
+        UpdateContentLength();
     }
 
     void HttpMessage::ClearContent() {
         _content.clear();
-        SetHeader("Content-Length", "0");
+        UpdateContentLength();
+    }
+
+    void HttpMessage::UpdateContentLength() {
+        // Formatted in place, std::to_string would allocate outside the arena
+        char digits[20];
+        char* end = digits + sizeof(digits);
+        char* begin = end;
+        size_t length = _content.length();
+        do {
+            *--begin = static_cast<char>('0' + length % 10);
+            length /= 10;
+        } while (length);
+        SetHeader("Content-Length", StringView(begin, end - begin));
     }
 
     HttpVersion HttpMessage::GetVersion() const {
         return _version;
     }
 
-    std::string HttpMessage::GetHeader(const std::string& key) const {
+    std::string HttpMessage::GetHeader(StringView key) const {
         auto it = _headers.find(key);
-        return it != _headers.end() ? it->second : std::string();
+        return it != _headers.end() ? std::string(it->second.data(), it->second.length()) : std::string();
     }
 
-    const std::map<std::string, std::string>& HttpMessage::GetHeaders() const {
-        return _headers;
+    bool HttpMessage::FindHeader(StringView key, StringView* value) const {
+        auto it = _headers.find(key);
+        if (it == _headers.end()) {
+            return false;
+        }
+        if (value) {
+            *value = StringView(it->second);
+        }
+        return true;
     }
 
-    const std::string& HttpMessage::GetContent() const {
-        return _content;
+    bool HttpMessage::FindHeaderIgnoreCase(StringView key, StringView* value) const {
+        if (FindHeader(key, value)) {
+            return true;
+        }
+        for (const auto& header : _headers) {
+            StringView name(header.first);
+            if (name.Length() != key.Length()) {
+                continue;
+            }
+            size_t i = 0;
+            while (i < key.Length() &&
+                   std::tolower(static_cast<unsigned char>(name[i])) == std::tolower(static_cast<unsigned char>(key[i]))) {
+                ++i;
+            }
+            if (i == key.Length()) {
+                if (value) {
+                    *value = StringView(header.second);
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::map<std::string, std::string> HttpMessage::GetHeaders() const {
+        std::map<std::string, std::string> headers;
+        for (const auto& header : _headers) {
+            headers.emplace_hint(headers.end(), std::string(header.first.data(), header.first.length()),
+                                 std::string(header.second.data(), header.second.length()));
+        }
+        return headers;
+    }
+
+    std::string HttpMessage::GetContent() const {
+        return std::string(_content.data(), _content.length());
+    }
+
+    StringView HttpMessage::GetContentView() const {
+        return StringView(_content);
     }
 
     size_t HttpMessage::GetContentLength() const {
         return _content.length();
     }
 
+    Arena* HttpMessage::GetArena() const {
+        return _headers.get_allocator().GetArena();
+    }
+
     void HttpRequest::SetMethod(HttpMethod method) {
         _method = method;
     }
 
     void HttpRequest::SetURI(const URI& uri) {
         _uri = uri;
+        _uriView = URIView();
+    }
+
+    void HttpRequest::SetURIView(const URIView& uriView) {
+        _uriView = uriView;
+        _uri = URI();
     }
 
     HttpMethod HttpRequest::GetMethod() const {
@@ -72,9 +159,17 @@ namespace httpserver {
     }
 
     const URI& HttpRequest::GetURI() const {
+        // Owning copy is only built for callers that still need it
+        if (!_uri.IsValid() && _uriView.IsValid()) {
+            _uri.Parse(_uriView.GetRaw().ToString());
+        }
         return _uri;
     }
 
+    const URIView& HttpRequest::GetURIView() const {
+        return _uriView;
+    }
+
     HttpResponse::HttpResponse(HttpStatusCode statusCode) : _statusCode(statusCode) {
         if (statusCode == HttpStatusCode::NoContent) {
             ClearContent();
@@ -1,13 +1,20 @@
 #include <arpa/inet.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
 #include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cctype>
 #include <cerrno>
 #include <chrono>
 #include <cstring>
 #include <functional>
+#include <iostream>
 #include <map>
 #include <sstream>
 #include <stdexcept>
@@ -15,45 +22,107 @@
 
 #include "../../include/http/http_server.h"
 #include "../../include/http/uri.h"
+#include "../../include/utils/scan.h"
 #include "../../include/utils/serialize.h"
 
 namespace httpserver {
 
-    HttpServer::HttpServer(const std::string &host, std::uint16_t port) : 
-        _host(host),
-        _port(port),
-        _socketFd(0),
-        _running(false),
-        _workerEpollFd(),
-        _randomGenerator(std::chrono::steady_clock::now().time_since_epoch().count()),
-        _sleepTimeRange(config::SLEEP_TIME_MIN, config::SLEEP_TIME_MAX) {
-        CreateSocket();
-    }
+    namespace {
+        bool EqualsIgnoreCase(StringView lhs, StringView rhs) {
+            if (lhs.Length() != rhs.Length()) return false;
+            for (size_t i = 0; i < lhs.Length(); ++i) {
+                if (std::tolower(static_cast<unsigned char>(lhs[i])) != std::tolower(static_cast<unsigned char>(rhs[i]))) {
+                    return false;
+                }
+            }
+            return true;
+        }
 
-    void HttpServer::Start() {
-        int opt = 1;
-        sockaddr_in serverAddress;
+        // Matches one element of a comma separated header such as "Connection: keep-alive, Upgrade"
+        bool HasTokenIgnoreCase(StringView list, StringView token) {
+            size_t start = 0;
+            while (start <= list.Length()) {
+                size_t end = list.Find(',', start);
+                if (end == StringView::npos) end = list.Length();
+                const char* begin = list.Data() + start;
+                const char* last = list.Data() + end;
+                scan::TrimWhitespace(begin, last);
+                if (EqualsIgnoreCase(StringView(begin, last - begin), token)) {
+                    return true;
+                }
+                start = end + 1;
+            }
+            return false;
+        }
+
+        // Set by signal handlers inside a prefork worker process
+        volatile sig_atomic_t gWorkerStop = 0;
+        volatile sig_atomic_t gWorkerReopen = 0;
 
-        if (setsockopt(_socketFd, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
-            throw std::runtime_error("Failed to set socket options");
+        void OnWorkerSignal(int signal) {
+            if (signal == SIGHUP) {
+                gWorkerReopen = 1;
+            } else {
+                gWorkerStop = 1;
+            }
         }
 
-        serverAddress.sin_family = AF_INET;
-        serverAddress.sin_addr.s_addr = INADDR_ANY;
-        inet_pton(AF_INET, _host.c_str(), &(serverAddress.sin_addr.s_addr));
-        serverAddress.sin_port = htons(_port);
+        sigset_t WorkerSignals() {
+            sigset_t signals;
+            sigemptyset(&signals);
+            sigaddset(&signals, SIGTERM);
+            sigaddset(&signals, SIGHUP);
+            return signals;
+        }
 
-        if (bind(_socketFd, (sockaddr *)&serverAddress, sizeof(serverAddress)) < 0) {
-            throw std::runtime_error("Failed to bind to socket");
+        // OpenSSL writes records with write(2), which has no MSG_NOSIGNAL, so a peer that resets a
+        // TLS connection would raise SIGPIPE. Without TLS listeners the process handler is left alone.
+        void IgnoreSigpipeForTls(const std::vector<std::unique_ptr<Listener>>& listeners) {
+            for (const auto& listener : listeners) {
+                if (listener->GetTls() != nullptr) {
+                    signal(SIGPIPE, SIG_IGN);
+                    return;
+                }
+            }
         }
+    }
+
+    HttpServer::HttpServer() : 
+        _host(),
+        _port(0),
+        _running(false),
+        _workerCount(config::WORKER_POOL_SIZE),
+        _reopenWorkers(false),
+        _processSlot(-1),
+        _workerEpollFd(),
+        _loadBalancer(new LoadBalancer(LoadBalancerConfig())),
+        _traceBatchStart(),
+        _randomGenerator(std::chrono::steady_clock::now().time_since_epoch().count()),
+        _sleepTimeRange(config::SLEEP_TIME_MIN, config::SLEEP_TIME_MAX) {}
+
+    HttpServer::HttpServer(const std::string &host, std::uint16_t port) : HttpServer() {
+        _host = host;
+        _port = port;
+        AddListener(ListenerConfig::Tcp(host, port));
+    }
 
-        if (listen(_socketFd, config::BACKLOG_SIZE) < 0) {
-            std::ostringstream msg;
-            msg << "Failed to listen on port " << _port;
-            throw std::runtime_error(msg.str());
+    void HttpServer::Start() {
+        if (_listeners.empty()) {
+            throw std::logic_error("No listeners configured");
+        }
+        for (auto &listener : _listeners) {
+            listener->Open();
         }
+        IgnoreSigpipeForTls(_listeners);
 
         Initialize();
+        if (_accessLog) {
+            _accessLog->Start();
+        }
+        if (_rateLimiter) {
+            _rateLimiter->Start();
+        }
+        _loadBalancer->Start();
         _running = true;
         _listenerThread = std::thread(&HttpServer::Listen, this);
         for (int i = 0; i < config::WORKER_POOL_SIZE; ++i) {
@@ -61,8 +130,48 @@ namespace httpserver {
         }
     }
 
+    void HttpServer::StartPrefork(int processes) {
+        if (_listeners.empty()) {
+            throw std::logic_error("No listeners configured");
+        }
+        _processStats.reset(new ProcessStatsSegment(processes));
+        for (auto &listener : _listeners) {
+            listener->Open();
+        }
+        if (_statsListener) {
+            _statsListener->Open();
+        }
+        IgnoreSigpipeForTls(_listeners);
+
+        // The master runs no event loop of its own
+        _workerCount = 0;
+        _workerPids.assign(processes, -1);
+        _workerStarts.assign(processes, std::chrono::steady_clock::time_point());
+        for (int i = 0; i < processes; ++i) {
+            if (SpawnWorkerProcess(i) < 0) {
+                StopWorkerProcesses();
+                throw std::runtime_error("Failed to fork worker process");
+            }
+        }
+        _running = true;
+        _supervisorThread = std::thread(&HttpServer::Supervise, this);
+    }
+
     void HttpServer::Stop() {
         _running = false;
+
+        if (_supervisorThread.joinable()) {
+            // Prefork master, the epoll sets and services live in the worker processes
+            _supervisorThread.join();
+            StopWorkerProcesses();
+            for (auto &listener : _listeners) {
+                listener->Close();
+            }
+            if (_statsListener) {
+                _statsListener->Close();
+            }
+            return;
+        }
         
         if (_listenerThread.joinable()) {
             _listenerThread.join();
@@ -79,15 +188,19 @@ namespace httpserver {
                 close(_workerEpollFd[i]);
             }
         }
-        
-        if (_socketFd >= 0) {
-            close(_socketFd);
+
+        if (_accessLog) {
+            _accessLog->Stop();
         }
-    }
 
-    void HttpServer::CreateSocket() {
-        if ((_socketFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0)) < 0) {
-            throw std::runtime_error("Failed to create a TCP socket");
+        if (_rateLimiter) {
+            _rateLimiter->Stop();
+        }
+
+        _loadBalancer->Stop();
+        
+        for (auto &listener : _listeners) {
+            listener->Close();
         }
     }
 
@@ -101,31 +214,252 @@ namespace httpserver {
     }
 
     void HttpServer::Listen() {
-        EventData *clientData;
-        sockaddr_in clientAddress;
-        socklen_t clientLen = sizeof(clientAddress);
+        PeerAddress peer;
         int clientFd;
-        int currentWorker = 0;
-        bool active = true;
+        size_t next = 0;
+        size_t idle = 0;
 
         while (_running) {
-            if (!active) {
+            if (idle >= _listeners.size()) {
                 // Random sleep to prevent thundering herd problem
                 std::this_thread::sleep_for(std::chrono::microseconds(_sleepTimeRange(_randomGenerator)));
+                idle = 0;
             }
-            
-            clientFd = accept4(_socketFd, (sockaddr *)&clientAddress, &clientLen, SOCK_NONBLOCK);
+
+            // Listeners take turns, the listener sleeps once a full pass found nothing to accept
+            Listener &listener = *_listeners[next];
+            if (++next == _listeners.size())
+                next = 0;
+            clientFd = listener.Accept(&peer);
             if (clientFd < 0) {
-                active = false;
+                ++idle;
                 continue;
             }
 
-            active = true;
-            clientData = new EventData();
-            clientData->fd = clientFd;
-            ControlEvent(_workerEpollFd[currentWorker], EPOLL_CTL_ADD, clientFd, EPOLLIN, clientData);
-            if (++currentWorker == config::WORKER_POOL_SIZE) 
-                currentWorker = 0;
+            idle = 0;
+            if (RejectAtAccept(clientFd, peer, RateLimiter::LISTENER_SHARD)) {
+                continue;
+            }
+            AddConnection(clientFd, peer, _loadBalancer->PickWorker(), listener.GetTls());
+        }
+    }
+
+    bool HttpServer::RejectAtAccept(int clientFd, const PeerAddress &peer, int shard) {
+        if (!_rateLimiter || _rateLimiter->GetConfig().mode != RateLimitMode::Accept ||
+            _rateLimiter->Allow(shard, _rateLimiter->KeyFor(peer))) {
+            return false;
+        }
+        // Best effort, the socket buffer of a fresh connection always has room for this
+        StringView rejection = _rateLimiter->GetRejection();
+        send(clientFd, rejection.Data(), rejection.Length(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        close(clientFd);
+        return true;
+    }
+
+    bool HttpServer::AddConnection(int clientFd, const PeerAddress &peer, int worker, TlsContext *tls) {
+        EventData *clientData = new EventData();
+        if (tls != nullptr) {
+            try {
+                clientData->tls = new TlsSession(*tls, clientFd);
+            }
+            catch (const std::exception &) {
+                close(clientFd);
+                delete clientData;
+                return false;
+            }
+        }
+        clientData->fd = clientFd;
+        clientData->workerId = worker;
+        clientData->peer = peer;
+        _loadBalancer->AddConnection(worker);
+        ControlEvent(_workerEpollFd[worker], EPOLL_CTL_ADD, clientFd, EPOLLIN, clientData);
+        return true;
+    }
+
+    void HttpServer::AcceptConnections(int workerId, Listener &listener) {
+        // Bounded, so that one process does not take a whole burst while its siblings sit idle
+        PeerAddress peer;
+        for (int i = 0; i < config::PREFORK_ACCEPT_BATCH; ++i) {
+            int clientFd = listener.Accept(&peer);
+            if (clientFd < 0) {
+                return;
+            }
+            if (RejectAtAccept(clientFd, peer, workerId)) {
+                continue;
+            }
+            if (AddConnection(clientFd, peer, workerId, listener.GetTls())) {
+                _processStats->AddConnection(_processSlot);
+            }
+        }
+    }
+
+    pid_t HttpServer::SpawnWorkerProcess(int slot) {
+        // Stop and reopen signals wait until the child has replaced the master's handlers
+        pid_t master = getpid();
+        sigset_t signals = WorkerSignals();
+        sigset_t previous;
+        pthread_sigmask(SIG_BLOCK, &signals, &previous);
+        pid_t pid = fork();
+        if (pid == 0) {
+            RunWorkerProcess(slot, master);
+        }
+        pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+
+        if (pid > 0) {
+            _workerPids[slot] = pid;
+            _workerStarts[slot] = std::chrono::steady_clock::now();
+            _processStats->SetPid(slot, pid);
+        }
+        return pid;
+    }
+
+    void HttpServer::RunWorkerProcess(int slot, pid_t master) {
+        // Ctrl+C reaches the whole process group, but only the master decides when workers stop
+        signal(SIGINT, SIG_IGN);
+        signal(SIGTERM, OnWorkerSignal);
+        signal(SIGHUP, OnWorkerSignal);
+        sigset_t signals = WorkerSignals();
+        pthread_sigmask(SIG_UNBLOCK, &signals, nullptr);
+
+        _processSlot = slot;
+        _workerCount = 1;
+        int status = 0;
+        try {
+            Initialize();
+            for (auto &listener : _listeners) {
+                EventData *entry = new EventData();
+                entry->fd = listener->GetFd();
+                entry->listener = listener.get();
+                // Wakes one process per incoming connection rather than every process
+                ControlEvent(_workerEpollFd[0], EPOLL_CTL_ADD, entry->fd, EPOLLIN | EPOLLEXCLUSIVE, entry);
+            }
+            if (_accessLog) {
+                _accessLog->Start();
+            }
+            if (_rateLimiter) {
+                _rateLimiter->Start();
+            }
+            _running = true;
+            _workerThreads[0] = std::thread(&HttpServer::ProcessEvents, this, 0);
+
+            // A worker whose master died is reparented and stops on its own
+            while (!gWorkerStop && getppid() == master) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(config::PREFORK_SUPERVISE_INTERVAL));
+                if (gWorkerReopen) {
+                    gWorkerReopen = 0;
+                    if (_accessLog) _accessLog->Reopen();
+                }
+            }
+
+            _running = false;
+            _workerThreads[0].join();
+            if (_accessLog) {
+                _accessLog->Stop();
+            }
+            if (_rateLimiter) {
+                _rateLimiter->Stop();
+            }
+        }
+        catch (const std::exception &e) {
+            std::cerr << "Worker process " << slot << ": " << e.what() << std::endl;
+            status = 1;
+        }
+        // Skips the destructors, which would close the master's listeners and unlink their paths
+        _exit(status);
+    }
+
+    void HttpServer::Supervise() {
+        while (_running) {
+            ReapWorkerProcesses();
+            if (_reopenWorkers.exchange(false)) {
+                for (pid_t pid : _workerPids) {
+                    if (pid > 0) kill(pid, SIGHUP);
+                }
+            }
+
+            if (_statsListener) {
+                pollfd ready = {_statsListener->GetFd(), POLLIN, 0};
+                if (poll(&ready, 1, config::PREFORK_SUPERVISE_INTERVAL) > 0) {
+                    ServeProcessStats();
+                }
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(config::PREFORK_SUPERVISE_INTERVAL));
+            }
+        }
+    }
+
+    void HttpServer::ReapWorkerProcesses() {
+        auto now = std::chrono::steady_clock::now();
+        for (size_t slot = 0; slot < _workerPids.size(); ++slot) {
+            pid_t pid = _workerPids[slot];
+            int status = 0;
+            if (pid > 0) {
+                pid_t reaped = waitpid(pid, &status, WNOHANG);
+                if (reaped == pid || (reaped < 0 && errno == ECHILD)) {
+                    std::cerr << "Worker process " << pid;
+                    if (WIFSIGNALED(status)) {
+                        std::cerr << " killed by signal " << WTERMSIG(status);
+                    } else {
+                        std::cerr << " exited with status " << WEXITSTATUS(status);
+                    }
+                    std::cerr << ", restarting" << std::endl;
+                    _workerPids[slot] = -1;
+                    _processStats->MarkExited(slot);
+                }
+            }
+
+            // A process that dies right after starting is restarted at most once per PREFORK_RESTART_DELAY
+            if (_workerPids[slot] < 0 &&
+                now - _workerStarts[slot] >= std::chrono::milliseconds(config::PREFORK_RESTART_DELAY) &&
+                SpawnWorkerProcess(slot) > 0) {
+                _processStats->AddRestart(slot);
+            }
+        }
+    }
+
+    void HttpServer::ServeProcessStats() {
+        PeerAddress peer;
+        int fd = _statsListener->Accept(&peer);
+        if (fd < 0) {
+            return;
+        }
+
+        // The request is not looked at, reading it only avoids resetting the connection on close
+        char request[config::MAX_BUFFER_SIZE];
+        pollfd readable = {fd, POLLIN, 0};
+        if (poll(&readable, 1, config::PREFORK_STATS_READ_TIMEOUT) > 0) {
+            recv(fd, request, sizeof(request), 0);
+        }
+
+        HttpResponse response(HttpStatusCode::OK);
+        response.SetHeader("Content-Type", "text/plain");
+        response.SetHeader("Connection", "close");
+        response.SetContent(_processStats->Format());
+        std::string raw = ToString(response);
+        send(fd, raw.data(), raw.size(), MSG_NOSIGNAL);
+        close(fd);
+    }
+
+    void HttpServer::StopWorkerProcesses() {
+        for (pid_t pid : _workerPids) {
+            if (pid > 0) kill(pid, SIGTERM);
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config::PREFORK_STOP_TIMEOUT);
+        for (size_t slot = 0; slot < _workerPids.size(); ++slot) {
+            pid_t pid = _workerPids[slot];
+            if (pid <= 0) continue;
+            int status;
+            while (waitpid(pid, &status, WNOHANG) == 0) {
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    kill(pid, SIGKILL);
+                    waitpid(pid, &status, 0);
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            _workerPids[slot] = -1;
+            _processStats->MarkExited(slot);
         }
     }
 
@@ -133,72 +467,121 @@ namespace httpserver {
         EventData *data;
         int epollFd = _workerEpollFd[workerId];
         bool active = true;
+        // A worker process owns its loop and has no other thread to hand it work, so it blocks in
+        // epoll_wait. EPOLLEXCLUSIVE on the shared listeners only picks among blocked waiters.
+        int timeout = _processSlot >= 0 ? config::PREFORK_EPOLL_TIMEOUT : 0;
 
         while (_running) {
-            if (!active) {
+            if (!active && timeout == 0) {
                 // Random sleep to prevent thundering herd problem
                 std::this_thread::sleep_for(std::chrono::microseconds(_sleepTimeRange(_randomGenerator)));
             }
-            int ec = epoll_wait(epollFd, _workerEvents[workerId], config::MAX_EVENTS, 0);
+            if (_webSocketMailboxes[workerId].pending.load(std::memory_order_acquire)) {
+                DrainWebSocketMailbox(epollFd, workerId);
+            }
+            int ec = epoll_wait(epollFd, _workerEvents[workerId], config::MAX_EVENTS, timeout);
             if (ec <= 0) {
                 active = false;
                 continue;
             }
 
             active = true;
+            auto batchStart = std::chrono::steady_clock::now();
+            if (_tracer) {
+                _traceBatchStart[workerId] = RequestTracer::Now();
+            }
             for (int i = 0; i < ec; ++i) {
                 const epoll_event &currentEvent = _workerEvents[workerId][i];
                 data = reinterpret_cast<EventData*>(currentEvent.data.ptr);
-                if ((currentEvent.events & EPOLLHUP) ||
+                if (data->listener != nullptr) {
+                    AcceptConnections(workerId, *data->listener);
+                } else if (data->webSocket != nullptr) {
+                    HandleWebSocketEvent(epollFd, data, currentEvent.events);
+                } else if ((currentEvent.events & EPOLLHUP) ||
                     (currentEvent.events & EPOLLERR)) {
-                    ControlEvent(epollFd, EPOLL_CTL_DEL, data->fd);
-                    close(data->fd);
-                    delete data;
+                    CloseConnection(epollFd, data);
                 } else if (currentEvent.events == EPOLLIN) {
                     Receive(epollFd, data);
                 } else if (currentEvent.events == EPOLLOUT) {
                     Send(epollFd, data);
                 } else {
-                    ControlEvent(epollFd, EPOLL_CTL_DEL, data->fd);
-                    close(data->fd);
-                    delete data;
+                    CloseConnection(epollFd, data);
                 }
             }
+            _loadBalancer->AddBusyTime(workerId, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - batchStart).count(), ec);
+        }
+    }
+
+    void HttpServer::ContinueHandshake(int epollFd, EventData* data) {
+        switch (data->tls->Handshake()) {
+            case TlsHandshakeStatus::Done:
+                // The first request often arrives together with the client's Finished message
+                Receive(epollFd, data);
+                break;
+            case TlsHandshakeStatus::WantRead:
+                ControlEvent(epollFd, EPOLL_CTL_MOD, data->fd, EPOLLIN, data);
+                break;
+            case TlsHandshakeStatus::WantWrite:
+                ControlEvent(epollFd, EPOLL_CTL_MOD, data->fd, EPOLLOUT, data);
+                break;
+            case TlsHandshakeStatus::Failed:
+                CloseConnection(epollFd, data);
+                break;
         }
     }
 
     void HttpServer::Receive(int epollFd, EventData* data) {
         int fd = data->fd;
         EventData* request = data;
-        ssize_t byteCount = recv(fd, request->buffer, config::MAX_BUFFER_SIZE, 0);
+        if (request->tls != nullptr && !request->tls->IsEstablished()) {
+            ContinueHandshake(epollFd, request);
+            return;
+        }
+        ssize_t byteCount = request->tls != nullptr ? request->tls->Read(request->buffer, config::MAX_BUFFER_SIZE)
+                                                    : recv(fd, request->buffer, config::MAX_BUFFER_SIZE, 0);
         
         if (byteCount > 0) {
             request->length = byteCount;
-            EventData* response = new EventData();
-            response->fd = fd;
+            EventData* response = request->pair;
+            if (response == nullptr) {
+                response = new EventData();
+                response->fd = fd;
+                response->workerId = request->workerId;
+                response->peer = request->peer;
+                response->tls = request->tls;
+                response->pair = request;
+                request->pair = response;
+            }
+            response->cursor = 0;
             ProcessData(*request, response);
             ControlEvent(epollFd, EPOLL_CTL_MOD, fd, EPOLLOUT, response);
-            delete request;
         } else if (byteCount == 0) {
-            ControlEvent(epollFd, EPOLL_CTL_DEL, fd);
-            close(fd);
-            delete request;
+            CloseConnection(epollFd, request);
         } else {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 request->fd = fd;
                 ControlEvent(epollFd, EPOLL_CTL_MOD, fd, EPOLLIN, request);
             } else {
-                ControlEvent(epollFd, EPOLL_CTL_DEL, fd);
-                close(fd);
-                delete request;
+                CloseConnection(epollFd, request);
             }
         }
     }
 
     void HttpServer::Send(int epollFd, EventData *data) {
         int fd = data->fd;
+        if (data->tls != nullptr && !data->tls->IsEstablished()) {
+            // Only the request side exists while the handshake waits for EPOLLOUT
+            ContinueHandshake(epollFd, data);
+            return;
+        }
         EventData* response = data;
-        ssize_t byteCount = send(fd, response->buffer + response->cursor, response->length, 0);
+        const char* buffer = response->overflow.empty() ? response->buffer : response->overflow.data();
+        if (response->traced) {
+            ++response->trace.record.sendCalls;
+        }
+        ssize_t byteCount = response->tls != nullptr ? response->tls->Write(buffer + response->cursor, response->length)
+                                                     : send(fd, buffer + response->cursor, response->length, MSG_NOSIGNAL);
         
         if (byteCount >= 0) {
             if (byteCount < response->length) {
@@ -206,19 +589,34 @@ namespace httpserver {
                 response->length -= byteCount;
                 ControlEvent(epollFd, EPOLL_CTL_MOD, fd, EPOLLOUT, response);
             } else {
+                if (response->traced) {
+                    FinishTrace(response);
+                }
+                if (!response->overflow.empty()) {
+                    std::string().swap(response->overflow);
+                }
+                if (response->pendingWebSocket != nullptr) {
+                    OpenWebSocket(epollFd, response);
+                    return;
+                }
                 // HTTP keep-alive, reuse connection for next request
-                EventData *request = new EventData();
-                request->fd = fd;
-                ControlEvent(epollFd, EPOLL_CTL_MOD, fd, EPOLLIN, request);
-                delete response;
+                EventData *request = response->pair;
+                request->length = 0;
+                int target = _loadBalancer->TakeMigration(response->workerId);
+                if (request->tls != nullptr && request->tls->HasPending()) {
+                    // Already decrypted bytes never show up as EPOLLIN
+                    Receive(epollFd, request);
+                } else if (target >= 0 && target != response->workerId) {
+                    MigrateConnection(epollFd, request, target);
+                } else {
+                    ControlEvent(epollFd, EPOLL_CTL_MOD, fd, EPOLLIN, request);
+                }
             }
         } else {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                ControlEvent(epollFd, EPOLL_CTL_ADD, fd, EPOLLOUT, response);
+                ControlEvent(epollFd, EPOLL_CTL_MOD, fd, EPOLLOUT, response);
             } else {
-                ControlEvent(epollFd, EPOLL_CTL_DEL, fd);
-                close(fd);
-                delete response;
+                CloseConnection(epollFd, response);
             }
         }
     }
@@ -239,37 +637,196 @@ namespace httpserver {
         }
     }
 
+    void HttpServer::CloseConnection(int epollFd, EventData *data) {
+        ControlEvent(epollFd, EPOLL_CTL_DEL, data->fd);
+        _loadBalancer->RemoveConnection(data->workerId);
+        if (_processSlot >= 0) {
+            _processStats->RemoveConnection(_processSlot);
+        }
+        for (EventData *side : {data, data->pair}) {
+            if (side == nullptr) continue;
+            if (side->webSocket != nullptr) {
+                // Runs the close handler while the session is still valid
+                _webSocketSessions[side->workerId].erase(side);
+                delete side->webSocket;
+            }
+            delete side->pendingWebSocket;
+        }
+        delete data->tls;
+        close(data->fd);
+        delete data->pair;
+        delete data;
+    }
+
+    void HttpServer::MigrateConnection(int epollFd, EventData *request, int targetWorker) {
+        // Nothing is in flight between requests, so both halves change owner at once. The target
+        // worker may pick the connection up as soon as it is in its epoll set.
+        int sourceWorker = request->workerId;
+        ControlEvent(epollFd, EPOLL_CTL_DEL, request->fd);
+        request->workerId = targetWorker;
+        request->pair->workerId = targetWorker;
+        _loadBalancer->MoveConnection(sourceWorker, targetWorker);
+        ControlEvent(_workerEpollFd[targetWorker], EPOLL_CTL_ADD, request->fd, EPOLLIN, request);
+    }
+
     void HttpServer::ProcessData(const EventData &rawRequest,
                                     EventData *rawResponse) {
-        std::string requestStr(rawRequest.buffer, rawRequest.length), responseStr;
-        HttpRequest request;
-        HttpResponse response;
+        // Everything built for this request comes from the worker arena, released in one step below
+        Arena &arena = _workerArenas[rawRequest.workerId];
+        {
+            Arena::Scope arenaScope(arena);
+            HttpRequest request;
+            HttpResponse response;
+            std::chrono::steady_clock::time_point start;
+            if (_accessLog) {
+                start = std::chrono::steady_clock::now();
+            }
 
-        try {
-            request = FromString<HttpRequest>(requestStr);
-            response = HandleRequest(request);
-        } 
-        catch (const std::invalid_argument &e) {
-            response = HttpResponse(HttpStatusCode::BadRequest);
-            response.SetContent(e.what());  
-        } 
-        catch (const std::logic_error &e) {
-            response = HttpResponse(HttpStatusCode::HttpVersionNotSupported);
-            response.SetContent(e.what());
-        } 
-        catch (const std::exception &e) {
-            response = HttpResponse(HttpStatusCode::InternalServerError);
-            response.SetContent(e.what());
+            // Unsampled requests only pay for this branch and the null checks on trace below
+            RequestTrace *trace = nullptr;
+            if (_tracer && _tracer->ShouldSample(rawRequest.workerId)) {
+                trace = &rawResponse->trace;
+                trace->marks[0] = _traceBatchStart[rawRequest.workerId];
+                trace->marks[1] = RequestTracer::Now();
+                std::fill(trace->marks + 2, trace->marks + TRACE_PHASE_COUNT + 1, 0);
+                trace->record.sendCalls = 0;
+            }
+            rawResponse->traced = trace != nullptr;
+
+            // Address-keyed limits reject before any parsing happens
+            bool limited = _rateLimiter && IsRateLimited(rawRequest, nullptr);
+
+            if (!limited) {
+                try {
+                    request = FromString<HttpRequest>(rawRequest.buffer, rawRequest.length);
+                    if (trace) trace->marks[2] = RequestTracer::Now();
+                    limited = _rateLimiter && IsRateLimited(rawRequest, &request);
+                    if (!limited) {
+                        const WebSocketHandler *webSocket = FindWebSocketHandler(request);
+                        response = webSocket != nullptr ? AcceptWebSocket(request, webSocket, rawResponse)
+                                                        : HandleRequest(request);
+                    }
+                    if (trace) trace->marks[3] = RequestTracer::Now();
+                } 
+                catch (const std::invalid_argument &e) {
+                    response = HttpResponse(HttpStatusCode::BadRequest);
+                    response.SetContent(e.what());  
+                } 
+                catch (const std::logic_error &e) {
+                    response = HttpResponse(HttpStatusCode::HttpVersionNotSupported);
+                    response.SetContent(e.what());
+                } 
+                catch (const std::exception &e) {
+                    response = HttpResponse(HttpStatusCode::InternalServerError);
+                    response.SetContent(e.what());
+                }
+            }
+
+            size_t responseLength;
+            if (limited) {
+                StringView rejection = _rateLimiter->GetRejection();
+                memcpy(rawResponse->buffer, rejection.Data(), rejection.Length());
+                responseLength = rejection.Length();
+            } else {
+                responseLength = ToBuffer(response, rawResponse->buffer, config::MAX_BUFFER_SIZE - 1);
+                if (responseLength == config::MAX_BUFFER_SIZE - 1) {
+                    // Possibly truncated, serialize again into a buffer sized to the response
+                    rawResponse->overflow = ToString(response);
+                    responseLength = rawResponse->overflow.length();
+                }
+            }
+            rawResponse->length = responseLength;
+            HttpStatusCode status = limited ? HttpStatusCode::TooManyRequests : response.GetStatusCode();
+            if (_processSlot >= 0) {
+                _processStats->AddRequest(_processSlot, static_cast<int>(status), responseLength);
+            }
+
+            if (trace) {
+                trace->marks[4] = RequestTracer::Now();
+                const URIView &uriView = request.GetURIView();
+                RequestTraceRecord &record = trace->record;
+                StringView target = uriView.IsValid() ? uriView.GetRaw() : StringView();
+                record.status = static_cast<std::uint16_t>(status);
+                record.method = uriView.IsValid() ? static_cast<std::uint8_t>(request.GetMethod())
+                                                  : RequestTraceRecord::METHOD_UNKNOWN;
+                record.pathLength = static_cast<std::uint8_t>(std::min(target.Length(), sizeof(record.path)));
+                memcpy(record.path, target.Data(), record.pathLength);
+            }
+
+            if (_accessLog) {
+                LogAccess(rawRequest, request, status, responseLength, start);
+            }
+        }
+        arena.Reset();
+    }
+
+    void HttpServer::FinishTrace(EventData *response) {
+        response->trace.marks[TRACE_PHASE_COUNT] = RequestTracer::Now();
+        _tracer->Record(response->workerId, response->trace);
+        response->traced = false;
+    }
+
+    bool HttpServer::IsRateLimited(const EventData &rawRequest, const HttpRequest *request) {
+        const RateLimitConfig &limit = _rateLimiter->GetConfig();
+        if (limit.mode != RateLimitMode::Request) {
+            return false;
         }
 
-        responseStr = ToString(response);
-        size_t responseLength = std::min(responseStr.length(), config::MAX_BUFFER_SIZE - 1);
-        memcpy(rawResponse->buffer, responseStr.c_str(), responseLength);
-        rawResponse->length = responseLength;
+        // Address keys are checked before parsing, header keys once the headers are known
+        std::uint64_t key;
+        if (limit.key == RateLimitKey::ClientAddress) {
+            if (request != nullptr) return false;
+            key = _rateLimiter->KeyFor(rawRequest.peer);
+        } else {
+            if (request == nullptr) return false;
+            StringView value;
+            key = request->FindHeaderIgnoreCase(limit.header, &value) ? _rateLimiter->KeyFor(value)
+                                                                      : _rateLimiter->KeyFor(rawRequest.peer);
+        }
+        return !_rateLimiter->Allow(rawRequest.workerId, key);
+    }
+
+    void HttpServer::LogAccess(const EventData &rawRequest, const HttpRequest &request,
+                               HttpStatusCode status, size_t bytes,
+                               std::chrono::steady_clock::time_point start) {
+        const URIView &uriView = request.GetURIView();
+        if (!_accessLog->ShouldSample(rawRequest.workerId, uriView.IsValid() ? uriView.GetPath() : StringView())) {
+            return;
+        }
+
+        AccessLogRecord record;
+        auto now = std::chrono::steady_clock::now();
+        record.timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        record.latencyUs = static_cast<std::uint32_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(now - start).count());
+        record.bytes = static_cast<std::uint32_t>(bytes);
+        record.status = static_cast<std::uint16_t>(status);
+        record.method = uriView.IsValid() ? static_cast<std::uint8_t>(request.GetMethod())
+                                          : AccessLogRecord::METHOD_UNKNOWN;
+        record.peer = rawRequest.peer;
+
+        auto copyField = [](StringView value, char *field, size_t size) {
+            size_t length = std::min(value.Length(), size);
+            memcpy(field, value.Data(), length);
+            return static_cast<std::uint8_t>(length);
+        };
+        auto findHeader = [&request](const char *key) {
+            StringView value;
+            request.FindHeaderIgnoreCase(key, &value);
+            return value;
+        };
+        record.pathLength = copyField(uriView.GetRaw(), record.path, sizeof(record.path));
+        record.refererLength = copyField(findHeader("Referer"), record.referer, sizeof(record.referer));
+        record.userAgentLength = copyField(findHeader("User-Agent"), record.userAgent, sizeof(record.userAgent));
+
+        _accessLog->Push(rawRequest.workerId, record);
     }
 
     HttpResponse HttpServer::HandleRequest(const HttpRequest &request) {
-        auto it = _requestHandlers.find(request.GetURI().GetPath());
+        const URIView& uriView = request.GetURIView();
+        auto it = uriView.IsValid() ? _requestHandlers.find(uriView.GetPath())
+                                    : _requestHandlers.find(request.GetURI().GetPath());
         if (it == _requestHandlers.end()) {
             return HttpResponse(HttpStatusCode::NotFound);
         }
@@ -281,6 +838,114 @@ namespace httpserver {
         return callbackIt->second(request);
     }
 
+    const WebSocketHandler* HttpServer::FindWebSocketHandler(const HttpRequest &request) const {
+        const URIView &uriView = request.GetURIView();
+        if (_webSocketHandlers.empty() || !uriView.IsValid()) {
+            return nullptr;
+        }
+
+        StringView upgrade;
+        if (!request.FindHeaderIgnoreCase("Upgrade", &upgrade) || !EqualsIgnoreCase(upgrade, "websocket")) {
+            return nullptr;
+        }
+        auto it = _webSocketHandlers.find(uriView.GetPath());
+        return it == _webSocketHandlers.end() ? nullptr : &it->second;
+    }
+
+    HttpResponse HttpServer::AcceptWebSocket(const HttpRequest &request, const WebSocketHandler *handler,
+                                             EventData *rawResponse) {
+        if (request.GetMethod() != HttpMethod::GET) {
+            return HttpResponse(HttpStatusCode::MethodNotAllowed);
+        }
+
+        StringView connection;
+        if (!request.FindHeaderIgnoreCase("Connection", &connection) || !HasTokenIgnoreCase(connection, "upgrade")) {
+            throw std::invalid_argument("Missing Connection: Upgrade");
+        }
+
+        StringView version;
+        if (!request.FindHeaderIgnoreCase("Sec-WebSocket-Version", &version) || version != "13") {
+            HttpResponse response(HttpStatusCode::UpgradeRequired);
+            response.SetHeader("Sec-WebSocket-Version", "13");
+            return response;
+        }
+
+        StringView key;
+        if (!request.FindHeaderIgnoreCase("Sec-WebSocket-Key", &key) || key.Empty()) {
+            throw std::invalid_argument("Missing Sec-WebSocket-Key");
+        }
+
+        HttpResponse response(HttpStatusCode::SwitchingProtocols);
+        std::string accept = ComputeWebSocketAccept(key);
+        response.SetHeader("Upgrade", "websocket");
+        response.SetHeader("Connection", "Upgrade");
+        response.SetHeader("Sec-WebSocket-Accept", accept);
+
+        // The session takes over the connection once the 101 response has been sent
+        rawResponse->pendingWebSocket = new WebSocketConnection(
+            rawResponse->fd, _workerEpollFd[rawResponse->workerId], rawResponse->pair, handler,
+            request.GetURIView().GetPath().ToString(), rawResponse->peer, rawResponse->tls);
+        return response;
+    }
+
+    void HttpServer::OpenWebSocket(int epollFd, EventData *response) {
+        EventData *request = response->pair;
+        request->length = 0;
+        request->webSocket = response->pendingWebSocket;
+        response->pendingWebSocket = nullptr;
+        _webSocketSessions[request->workerId].insert(request);
+
+        ControlEvent(epollFd, EPOLL_CTL_MOD, request->fd, EPOLLIN, request);
+        request->webSocket->Open();
+        if (request->webSocket->ShouldClose()) {
+            CloseConnection(epollFd, request);
+        }
+    }
+
+    void HttpServer::HandleWebSocketEvent(int epollFd, EventData *data, std::uint32_t events) {
+        WebSocketConnection *webSocket = data->webSocket;
+        if (events & (EPOLLHUP | EPOLLERR)) {
+            CloseConnection(epollFd, data);
+            return;
+        }
+
+        if (events & EPOLLIN) {
+            webSocket->OnReadable();
+        }
+        if ((events & EPOLLOUT) && !webSocket->ShouldClose()) {
+            webSocket->OnWritable();
+        }
+        if (webSocket->ShouldClose()) {
+            CloseConnection(epollFd, data);
+        }
+    }
+
+    void HttpServer::DrainWebSocketMailbox(int epollFd, int workerId) {
+        WebSocketMailbox &mailbox = _webSocketMailboxes[workerId];
+        std::vector<WebSocketBroadcast> broadcasts;
+        {
+            std::lock_guard<std::mutex> lock(mailbox.mutex);
+            broadcasts.swap(mailbox.broadcasts);
+            mailbox.pending.store(false, std::memory_order_relaxed);
+        }
+
+        std::vector<EventData*> closing;
+        for (EventData *data : _webSocketSessions[workerId]) {
+            WebSocketConnection *webSocket = data->webSocket;
+            for (const WebSocketBroadcast &broadcast : broadcasts) {
+                if (webSocket->GetPath() == broadcast.path) {
+                    webSocket->Send(broadcast.frame);
+                }
+            }
+            if (webSocket->ShouldClose()) {
+                closing.push_back(data);
+            }
+        }
+        for (EventData *data : closing) {
+            CloseConnection(epollFd, data);
+        }
+    }
+
     void HttpServer::RegisterRequestHandler(std::string path, HttpMethod method, const HttpRequestHandler callback) {
         if (path.empty() || path[0] != '/') {
             path = "/" + path;
@@ -288,6 +953,103 @@ namespace httpserver {
         _requestHandlers[path].insert(std::make_pair(method, std::move(callback)));
     }
 
+    void HttpServer::AddListener(const ListenerConfig& config) {
+        _listeners.emplace_back(new Listener(config));
+    }
+
+    const std::vector<std::unique_ptr<Listener>>& HttpServer::GetListeners() const {
+        return _listeners;
+    }
+
+    void HttpServer::SetProcessStatsListener(const ListenerConfig& config) {
+        _statsListener.reset(new Listener(config));
+    }
+
+    std::vector<ProcessStats> HttpServer::GetProcessStats() const {
+        std::vector<ProcessStats> stats;
+        for (int i = 0; _processStats && i < _processStats->GetProcessCount(); ++i) {
+            stats.push_back(_processStats->GetStats(i));
+        }
+        return stats;
+    }
+
+    void HttpServer::EnableAccessLog(const std::string& path, AccessLogFormat format) {
+        _accessLog.reset(new AccessLog(path, format));
+    }
+
+    void HttpServer::SetAccessLogSampleRate(std::string path, double rate) {
+        if (!_accessLog) {
+            throw std::logic_error("Access log is not enabled");
+        }
+        _accessLog->SetSampleRate(path, rate);
+    }
+
+    void HttpServer::ReopenAccessLog() {
+        if (_supervisorThread.joinable()) {
+            // Each worker process has its own log writer, the supervisor forwards SIGHUP to them
+            _reopenWorkers = true;
+        } else if (_accessLog) {
+            _accessLog->Reopen();
+        }
+    }
+
+    std::uint64_t HttpServer::GetDroppedAccessLogRecords() const {
+        return _accessLog ? _accessLog->GetDroppedCount() : 0;
+    }
+
+    void HttpServer::EnableRateLimit(const RateLimitConfig& config) {
+        _rateLimiter.reset(new RateLimiter(config));
+    }
+
+    std::uint64_t HttpServer::GetRateLimitedCount() const {
+        return _rateLimiter ? _rateLimiter->GetRejectedCount() : 0;
+    }
+
+    void HttpServer::SetLoadBalancing(const LoadBalancerConfig& config) {
+        _loadBalancer.reset(new LoadBalancer(config));
+    }
+
+    WorkerLoadStats HttpServer::GetWorkerLoad(int workerId) const {
+        return _loadBalancer->GetStats(workerId);
+    }
+
+    double HttpServer::GetLoadImbalance() const {
+        return _loadBalancer->GetImbalance();
+    }
+
+    void HttpServer::EnableRequestTracing(double sampleRate, std::string debugPath) {
+        _tracer.reset(new RequestTracer(sampleRate));
+        RequestTracer *tracer = _tracer.get();
+        RegisterRequestHandler(debugPath, HttpMethod::GET, [tracer](const HttpRequest &request) {
+            HttpResponse response(HttpStatusCode::OK);
+            if (request.GetURIView().GetQueryParam("format") == "chrome") {
+                response.SetHeader("Content-Type", "application/json");
+                response.SetContent(tracer->FormatChromeTrace());
+            } else {
+                response.SetHeader("Content-Type", "text/plain");
+                response.SetContent(tracer->FormatSummary());
+            }
+            return response;
+        });
+    }
+
+    void HttpServer::RegisterWebSocketHandler(std::string path, const WebSocketHandler handler) {
+        if (path.empty() || path[0] != '/') {
+            path = "/" + path;
+        }
+        _webSocketHandlers[path] = std::move(handler);
+    }
+
+    void HttpServer::BroadcastWebSocket(const std::string& path, WebSocketOpcode opcode, StringView payload) {
+        WebSocketFrame frame = MakeWebSocketFrame(opcode, payload);
+        for (int i = 0; i < _workerCount; ++i) {
+            WebSocketMailbox &mailbox = _webSocketMailboxes[i];
+            std::lock_guard<std::mutex> lock(mailbox.mutex);
+            mailbox.broadcasts.push_back(WebSocketBroadcast{path, frame});
+            mailbox.pending.store(true, std::memory_order_release);
+        }
+    }
+
     std::string HttpServer::GetHost() const { 
         return _host; 
     }
@@ -0,0 +1,252 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include "../../include/http/listener.h"
+
+namespace httpserver {
+
+    ListenerConfig::ListenerConfig(ListenerType type, const std::string& address, std::uint16_t port) :
+        type(type),
+        address(address),
+        port(port),
+        backlog(config::BACKLOG_SIZE),
+        v6Only(false),
+        noDelay(false),
+        deferAcceptSeconds(0),
+        fastOpenQueue(0),
+        unixMode(0),
+        tls() {}
+
+    ListenerConfig ListenerConfig::Tcp(const std::string& host, std::uint16_t port) {
+        return ListenerConfig(ListenerType::TCP, host, port);
+    }
+
+    ListenerConfig ListenerConfig::Unix(const std::string& path) {
+        return ListenerConfig(ListenerType::Unix, path, 0);
+    }
+
+    ListenerConfig ListenerConfig::Https(const std::string& host, std::uint16_t port, const TlsConfig& tls) {
+        ListenerConfig config(ListenerType::TCP, host, port);
+        config.tls = tls;
+        // Handshake flights and tickets go out as several small writes, Nagle would hold them for a delayed ACK
+        config.noDelay = true;
+        return config;
+    }
+
+    Listener::Listener(const ListenerConfig& config) : _config(config), _fd(-1), _boundPort(config.port), _ownsPath(false) {}
+
+    Listener::~Listener() {
+        Close();
+    }
+
+    void Listener::Open() {
+        // Certificate errors surface before the socket is bound
+        if (!_config.tls.certificateFile.empty()) {
+            _tls.reset(new TlsContext(_config.tls));
+        }
+
+        if (_config.type == ListenerType::Unix) {
+            OpenUnix();
+        } else {
+            OpenTcp();
+        }
+
+        if (listen(_fd, _config.backlog) < 0) {
+            std::ostringstream msg;
+            msg << "Failed to listen on " << Describe();
+            throw std::runtime_error(msg.str());
+        }
+    }
+
+    void Listener::Close() {
+        if (_fd < 0) {
+            return;
+        }
+        close(_fd);
+        _fd = -1;
+        if (_ownsPath) {
+            unlink(_config.address.c_str());
+            _ownsPath = false;
+        }
+    }
+
+    int Listener::Accept(PeerAddress* peer) {
+        sockaddr_storage clientAddress;
+        socklen_t clientLen = sizeof(clientAddress);
+        int clientFd = accept4(_fd, (sockaddr *)&clientAddress, &clientLen, SOCK_NONBLOCK);
+        if (clientFd < 0) {
+            return -1;
+        }
+
+        *peer = PeerAddress::FromSockaddr((sockaddr *)&clientAddress, clientLen);
+        if (_config.type == ListenerType::Unix) {
+            // Unix clients have no usable address, identify them by process instead
+            ucred credentials;
+            socklen_t length = sizeof(credentials);
+            peer->family = AF_UNIX;
+            if (getsockopt(clientFd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) == 0) {
+                std::uint32_t pid = static_cast<std::uint32_t>(credentials.pid);
+                std::memcpy(peer->address, &pid, sizeof(pid));
+            }
+        } else if (_config.noDelay) {
+            int enable = 1;
+            setsockopt(clientFd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        }
+        return clientFd;
+    }
+
+    const ListenerConfig& Listener::GetConfig() const {
+        return _config;
+    }
+
+    int Listener::GetFd() const {
+        return _fd;
+    }
+
+    TlsContext* Listener::GetTls() const {
+        return _tls.get();
+    }
+
+    std::uint16_t Listener::GetPort() const {
+        return _boundPort;
+    }
+
+    std::string Listener::Describe() const {
+        std::ostringstream description;
+        if (_config.type == ListenerType::Unix) {
+            description << "unix:" << _config.address;
+        } else if (_config.address.find(':') != std::string::npos) {
+            description << "[" << _config.address << "]:" << _boundPort;
+        } else {
+            description << _config.address << ":" << _boundPort;
+        }
+        if (_tls) {
+            description << " (TLS)";
+        }
+        return description.str();
+    }
+
+    void Listener::OpenTcp() {
+        sockaddr_storage address;
+        socklen_t addressLength;
+        std::memset(&address, 0, sizeof(address));
+
+        std::string host = _config.address;
+        if (host.size() >= 2 && host.front() == '[' && host.back() == ']') {
+            host = host.substr(1, host.size() - 2);
+        }
+
+        sockaddr_in* ipv4 = reinterpret_cast<sockaddr_in*>(&address);
+        sockaddr_in6* ipv6 = reinterpret_cast<sockaddr_in6*>(&address);
+        if (inet_pton(AF_INET, host.c_str(), &ipv4->sin_addr) == 1) {
+            ipv4->sin_family = AF_INET;
+            ipv4->sin_port = htons(_config.port);
+            addressLength = sizeof(sockaddr_in);
+        } else if (inet_pton(AF_INET6, host.c_str(), &ipv6->sin6_addr) == 1) {
+            ipv6->sin6_family = AF_INET6;
+            ipv6->sin6_port = htons(_config.port);
+            addressLength = sizeof(sockaddr_in6);
+        } else {
+            throw std::invalid_argument("Invalid listener address: " + _config.address);
+        }
+
+        if ((_fd = socket(address.ss_family, SOCK_STREAM | SOCK_NONBLOCK, 0)) < 0) {
+            throw std::runtime_error("Failed to create a TCP socket");
+        }
+
+        SetOption(SOL_SOCKET, SO_REUSEADDR, 1, "SO_REUSEADDR");
+        SetOption(SOL_SOCKET, SO_REUSEPORT, 1, "SO_REUSEPORT");
+        if (address.ss_family == AF_INET6) {
+            SetOption(IPPROTO_IPV6, IPV6_V6ONLY, _config.v6Only ? 1 : 0, "IPV6_V6ONLY");
+        }
+        if (_config.deferAcceptSeconds > 0) {
+            SetOption(IPPROTO_TCP, TCP_DEFER_ACCEPT, _config.deferAcceptSeconds, "TCP_DEFER_ACCEPT");
+        }
+        if (_config.fastOpenQueue > 0) {
+            SetOption(IPPROTO_TCP, TCP_FASTOPEN, _config.fastOpenQueue, "TCP_FASTOPEN");
+        }
+
+        if (bind(_fd, (sockaddr *)&address, addressLength) < 0) {
+            std::ostringstream msg;
+            msg << "Failed to bind to " << Describe();
+            throw std::runtime_error(msg.str());
+        }
+
+        // Resolve port 0 to the ephemeral port the kernel picked
+        if (getsockname(_fd, (sockaddr *)&address, &addressLength) == 0) {
+            _boundPort = ntohs(address.ss_family == AF_INET6 ? ipv6->sin6_port : ipv4->sin_port);
+        }
+    }
+
+    void Listener::OpenUnix() {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+
+        const std::string& path = _config.address;
+        if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument("Invalid Unix socket path: " + path);
+        }
+
+        // Abstract names start with a NUL byte and are not NUL terminated
+        bool abstract = path[0] == '@';
+        std::memcpy(address.sun_path, path.data(), path.size());
+        if (abstract) {
+            address.sun_path[0] = '\0';
+        }
+        socklen_t addressLength = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size() + (abstract ? 0 : 1));
+
+        if ((_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0)) < 0) {
+            throw std::runtime_error("Failed to create a Unix socket");
+        }
+
+        // A socket file left behind by a previous run would make bind fail. Only a socket that
+        // refuses connections is stale, a live one belongs to another server.
+        struct stat status;
+        if (!abstract && lstat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+            int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+            if (probe < 0) {
+                throw std::runtime_error("Failed to create a Unix socket");
+            }
+            // Non-blocking, a full backlog fails with EAGAIN instead of waiting
+            int connected = connect(probe, (sockaddr *)&address, addressLength);
+            int error = errno;
+            close(probe);
+            if (connected == 0 || error == EAGAIN) {
+                std::ostringstream msg;
+                msg << "Address already in use: " << Describe();
+                throw std::runtime_error(msg.str());
+            }
+            if (error == ECONNREFUSED) {
+                unlink(path.c_str());
+            }
+        }
+
+        if (bind(_fd, (sockaddr *)&address, addressLength) < 0) {
+            std::ostringstream msg;
+            msg << "Failed to bind to " << Describe();
+            throw std::runtime_error(msg.str());
+        }
+        _ownsPath = !abstract;
+        if (!abstract && _config.unixMode != 0 && chmod(path.c_str(), _config.unixMode) < 0) {
+            throw std::runtime_error("Failed to set permissions on " + path);
+        }
+    }
+
+    void Listener::SetOption(int level, int option, int value, const char* name) {
+        if (setsockopt(_fd, level, option, &value, sizeof(value)) < 0) {
+            throw std::runtime_error(std::string("Failed to set ") + name);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <chrono>
+
+#include "../../include/http/load_balancer.h"
+
+namespace httpserver {
+
+    LoadBalancer::LoadBalancer(const LoadBalancerConfig& config) :
+        _config(config),
+        _imbalancePpm(1000000),
+        _running(false),
+        _nextWorker(0),
+        _randomState(0x9E3779B97F4A7C15ULL),
+        _previousBusyNs(),
+        _load(),
+        _cooldown(0) {
+        for (int i = 0; i < config::WORKER_POOL_SIZE; ++i) {
+            _workers[i].reset(new WorkerState());
+            WorkerState& worker = *_workers[i];
+            worker.connections = 0;
+            worker.events = 0;
+            worker.busyNs = 0;
+            worker.loadPpm = 0;
+            worker.migrationTarget = -1;
+            worker.migrationBudget = 0;
+            worker.migratedIn = 0;
+            worker.migratedOut = 0;
+        }
+    }
+
+    LoadBalancer::~LoadBalancer() {
+        Stop();
+    }
+
+    void LoadBalancer::Start() {
+        _running = true;
+        _monitorThread = std::thread(&LoadBalancer::Run, this);
+    }
+
+    void LoadBalancer::Stop() {
+        _running = false;
+        if (_monitorThread.joinable()) {
+            _monitorThread.join();
+        }
+    }
+
+    int LoadBalancer::PickWorker() {
+        switch (_config.policy) {
+            case PlacementPolicy::LeastConnections: {
+                // Scan from the rotating start so ties spread out instead of piling on worker 0
+                int best = _nextWorker;
+                std::int64_t fewest = _workers[best]->connections.load(std::memory_order_relaxed);
+                for (int offset = 1; offset < config::WORKER_POOL_SIZE; ++offset) {
+                    int candidate = (_nextWorker + offset) % config::WORKER_POOL_SIZE;
+                    std::int64_t connections = _workers[candidate]->connections.load(std::memory_order_relaxed);
+                    if (connections < fewest) {
+                        best = candidate;
+                        fewest = connections;
+                    }
+                }
+                _nextWorker = (best + 1) % config::WORKER_POOL_SIZE;
+                return best;
+            }
+
+            case PlacementPolicy::PowerOfTwoChoices: {
+                if (config::WORKER_POOL_SIZE == 1) return 0;
+
+                // xorshift64, only the listener draws from it
+                _randomState ^= _randomState << 13;
+                _randomState ^= _randomState >> 7;
+                _randomState ^= _randomState << 17;
+                int first = static_cast<int>((_randomState >> 32) % config::WORKER_POOL_SIZE);
+                int second = static_cast<int>((_randomState & 0xFFFFFFFF) % (config::WORKER_POOL_SIZE - 1));
+                if (second >= first) ++second;
+
+                std::uint32_t firstLoad = _workers[first]->loadPpm.load(std::memory_order_relaxed);
+                std::uint32_t secondLoad = _workers[second]->loadPpm.load(std::memory_order_relaxed);
+                if (firstLoad != secondLoad) {
+                    return firstLoad < secondLoad ? first : second;
+                }
+                return _workers[first]->connections.load(std::memory_order_relaxed) <=
+                       _workers[second]->connections.load(std::memory_order_relaxed) ? first : second;
+            }
+
+            default: {
+                int worker = _nextWorker;
+                if (++_nextWorker == config::WORKER_POOL_SIZE) _nextWorker = 0;
+                return worker;
+            }
+        }
+    }
+
+    void LoadBalancer::AddConnection(int workerId) {
+        _workers[workerId]->connections.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void LoadBalancer::RemoveConnection(int workerId) {
+        _workers[workerId]->connections.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void LoadBalancer::MoveConnection(int fromWorker, int toWorker) {
+        RemoveConnection(fromWorker);
+        AddConnection(toWorker);
+        _workers[fromWorker]->migratedOut.fetch_add(1, std::memory_order_relaxed);
+        _workers[toWorker]->migratedIn.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void LoadBalancer::AddBusyTime(int workerId, std::uint64_t busyNs, std::uint32_t events) {
+        WorkerState& worker = *_workers[workerId];
+        worker.busyNs.fetch_add(busyNs, std::memory_order_relaxed);
+        worker.events.fetch_add(events, std::memory_order_relaxed);
+    }
+
+    int LoadBalancer::TakeMigration(int workerId) {
+        // A single relaxed load on the common path where nothing is asked of this worker
+        WorkerState& worker = *_workers[workerId];
+        if (worker.migrationBudget.load(std::memory_order_relaxed) <= 0) {
+            return -1;
+        }
+        if (worker.migrationBudget.fetch_sub(1, std::memory_order_acquire) <= 0) {
+            return -1;
+        }
+        return worker.migrationTarget.load(std::memory_order_relaxed);
+    }
+
+    const LoadBalancerConfig& LoadBalancer::GetConfig() const {
+        return _config;
+    }
+
+    WorkerLoadStats LoadBalancer::GetStats(int workerId) const {
+        const WorkerState& worker = *_workers[workerId];
+        WorkerLoadStats stats;
+        stats.connections = worker.connections.load(std::memory_order_relaxed);
+        stats.events = worker.events.load(std::memory_order_relaxed);
+        stats.load = worker.loadPpm.load(std::memory_order_relaxed) / 1e6;
+        stats.migratedIn = worker.migratedIn.load(std::memory_order_relaxed);
+        stats.migratedOut = worker.migratedOut.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    double LoadBalancer::GetImbalance() const {
+        return _imbalancePpm.load(std::memory_order_relaxed) / 1e6;
+    }
+
+    void LoadBalancer::Run() {
+        auto last = std::chrono::steady_clock::now();
+        while (_running) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(config::LOAD_SAMPLE_INTERVAL));
+            auto now = std::chrono::steady_clock::now();
+            Sample(std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count());
+            last = now;
+            if (_config.rebalance) {
+                Rebalance();
+            }
+        }
+    }
+
+    void LoadBalancer::Sample(std::uint64_t elapsedNs) {
+        if (elapsedNs == 0) return;
+
+        double total = 0;
+        double busiest = 0;
+        for (int i = 0; i < config::WORKER_POOL_SIZE; ++i) {
+            WorkerState& worker = *_workers[i];
+            std::uint64_t busyNs = worker.busyNs.load(std::memory_order_relaxed);
+            double sample = std::min(1.0, static_cast<double>(busyNs - _previousBusyNs[i]) / elapsedNs);
+            _previousBusyNs[i] = busyNs;
+
+            _load[i] = config::LOAD_SMOOTHING * sample + (1 - config::LOAD_SMOOTHING) * _load[i];
+            worker.loadPpm.store(static_cast<std::uint32_t>(_load[i] * 1e6), std::memory_order_relaxed);
+            total += _load[i];
+            busiest = std::max(busiest, _load[i]);
+        }
+
+        double mean = total / config::WORKER_POOL_SIZE;
+        double imbalance = mean > 0 ? busiest / mean : 1.0;
+        _imbalancePpm.store(static_cast<std::uint32_t>(imbalance * 1e6), std::memory_order_relaxed);
+    }
+
+    void LoadBalancer::Rebalance() {
+        int busiest = 0;
+        int idlest = 0;
+        double total = 0;
+        for (int i = 0; i < config::WORKER_POOL_SIZE; ++i) {
+            // Orders from the previous period are dropped, loads have moved since
+            _workers[i]->migrationBudget.store(0, std::memory_order_relaxed);
+            total += _load[i];
+            if (_load[i] > _load[busiest]) busiest = i;
+            if (_load[i] < _load[idlest]) idlest = i;
+        }
+
+        // Give the last migrations time to show up in the smoothed load before moving more
+        if (_cooldown > 0) {
+            --_cooldown;
+            return;
+        }
+
+        double mean = total / config::WORKER_POOL_SIZE;
+        if (busiest == idlest || _load[busiest] < config::LOAD_MIN_REBALANCE ||
+            _load[busiest] <= mean * _config.imbalanceThreshold) {
+            return;
+        }
+
+        // A worker with a single connection cannot shed load, moving it would only move the hot spot
+        std::int64_t connections = _workers[busiest]->connections.load(std::memory_order_relaxed);
+        if (connections <= 1) {
+            return;
+        }
+
+        int budget = static_cast<int>(std::min<std::int64_t>(config::LOAD_MIGRATION_BATCH, connections / 2));
+        WorkerState& worker = *_workers[busiest];
+        worker.migrationTarget.store(idlest, std::memory_order_relaxed);
+        worker.migrationBudget.store(budget, std::memory_order_release);
+        _cooldown = 2;
+    }
+}
\ No newline at end of file
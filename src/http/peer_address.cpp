@@ -0,0 +1,66 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "../../include/http/peer_address.h"
+
+namespace httpserver {
+
+    PeerAddress::PeerAddress() : family(AF_UNSPEC), port(0), address() {}
+
+    PeerAddress PeerAddress::FromSockaddr(const sockaddr* address, socklen_t length) {
+        PeerAddress peer;
+        if (address == nullptr) {
+            return peer;
+        }
+        if (address->sa_family == AF_INET && length >= sizeof(sockaddr_in)) {
+            const sockaddr_in* ipv4 = reinterpret_cast<const sockaddr_in*>(address);
+            peer.family = AF_INET;
+            peer.port = ntohs(ipv4->sin_port);
+            std::memcpy(peer.address, &ipv4->sin_addr, sizeof(ipv4->sin_addr));
+        } else if (address->sa_family == AF_INET6 && length >= sizeof(sockaddr_in6)) {
+            const sockaddr_in6* ipv6 = reinterpret_cast<const sockaddr_in6*>(address);
+            peer.port = ntohs(ipv6->sin6_port);
+            if (IN6_IS_ADDR_V4MAPPED(&ipv6->sin6_addr)) {
+                // IPv4 clients of a dual-stack listener, keyed and logged like on an IPv4 listener
+                peer.family = AF_INET;
+                std::memcpy(peer.address, ipv6->sin6_addr.s6_addr + 12, 4);
+            } else {
+                peer.family = AF_INET6;
+                std::memcpy(peer.address, &ipv6->sin6_addr, sizeof(ipv6->sin6_addr));
+            }
+        } else if (address->sa_family == AF_UNIX) {
+            peer.family = AF_UNIX;
+        }
+        return peer;
+    }
+
+    size_t PeerAddress::Format(char* buffer, size_t size) const {
+        if (size == 0) {
+            return 0;
+        }
+        if ((family == AF_INET || family == AF_INET6) &&
+            inet_ntop(family, address, buffer, static_cast<socklen_t>(size)) != nullptr) {
+            return std::strlen(buffer);
+        }
+        if (family == AF_UNIX) {
+            std::uint32_t pid;
+            std::memcpy(&pid, address, sizeof(pid));
+            int length = std::snprintf(buffer, size, "unix:%u", pid);
+            if (length > 0) {
+                return std::min(static_cast<size_t>(length), size - 1);
+            }
+        }
+        if (size < 2) {
+            buffer[0] = '\0';
+            return 0;
+        }
+        buffer[0] = '-';
+        buffer[1] = '\0';
+        return 1;
+    }
+
+}
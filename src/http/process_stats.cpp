@@ -0,0 +1,122 @@
+#include <sys/mman.h>
+
+#include <new>
+#include <sstream>
+#include <stdexcept>
+
+#include "../../include/http/process_stats.h"
+
+namespace httpserver {
+
+    // Atomics that fall back to a lock would keep that lock in private memory after fork
+    static_assert(ATOMIC_LONG_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+                  "Shared process counters need lock-free 64-bit atomics");
+
+    ProcessStatsSegment::ProcessStatsSegment(int processes) :
+        _processes(processes),
+        _size(sizeof(Slot) * processes),
+        _slots(nullptr) {
+        if (processes <= 0) {
+            throw std::invalid_argument("Process count must be positive");
+        }
+
+        void* memory = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            throw std::runtime_error("Failed to map the process stats segment");
+        }
+
+        // Value-initialized, so every counter starts at zero
+        _slots = static_cast<Slot*>(memory);
+        for (int i = 0; i < processes; ++i) {
+            new (&_slots[i]) Slot();
+        }
+    }
+
+    ProcessStatsSegment::~ProcessStatsSegment() {
+        munmap(_slots, _size);
+    }
+
+    int ProcessStatsSegment::GetProcessCount() const {
+        return _processes;
+    }
+
+    void ProcessStatsSegment::AddConnection(int slot) {
+        _slots[slot].accepted.fetch_add(1, std::memory_order_relaxed);
+        _slots[slot].active.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void ProcessStatsSegment::RemoveConnection(int slot) {
+        _slots[slot].active.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void ProcessStatsSegment::AddRequest(int slot, int status, size_t bytes) {
+        Slot& counters = _slots[slot];
+        counters.requests.fetch_add(1, std::memory_order_relaxed);
+        int statusClass = status / 100 - 1;
+        if (statusClass >= 0 && statusClass < 5) {
+            counters.responses[statusClass].fetch_add(1, std::memory_order_relaxed);
+        }
+        counters.bytesSent.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void ProcessStatsSegment::SetPid(int slot, pid_t pid) {
+        _slots[slot].pid.store(pid, std::memory_order_relaxed);
+    }
+
+    void ProcessStatsSegment::AddRestart(int slot) {
+        _slots[slot].restarts.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void ProcessStatsSegment::MarkExited(int slot) {
+        // Connections of a dead process were closed by the kernel
+        _slots[slot].pid.store(0, std::memory_order_relaxed);
+        _slots[slot].active.store(0, std::memory_order_relaxed);
+    }
+
+    ProcessStats ProcessStatsSegment::GetStats(int slot) const {
+        const Slot& counters = _slots[slot];
+        ProcessStats stats;
+        stats.pid = static_cast<pid_t>(counters.pid.load(std::memory_order_relaxed));
+        stats.restarts = counters.restarts.load(std::memory_order_relaxed);
+        stats.accepted = counters.accepted.load(std::memory_order_relaxed);
+        stats.active = counters.active.load(std::memory_order_relaxed);
+        stats.requests = counters.requests.load(std::memory_order_relaxed);
+        for (int i = 0; i < 5; ++i) {
+            stats.responses[i] = counters.responses[i].load(std::memory_order_relaxed);
+        }
+        stats.bytesSent = counters.bytesSent.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    std::string ProcessStatsSegment::Format() const {
+        ProcessStats total = ProcessStats();
+        std::ostringstream lines;
+        for (int i = 0; i < _processes; ++i) {
+            ProcessStats stats = GetStats(i);
+            lines << "process " << i << " pid " << stats.pid << " restarts " << stats.restarts
+                  << " accepted " << stats.accepted << " active " << stats.active
+                  << " requests " << stats.requests;
+            for (int j = 0; j < 5; ++j) {
+                lines << ' ' << j + 1 << "xx " << stats.responses[j];
+                total.responses[j] += stats.responses[j];
+            }
+            lines << " bytes " << stats.bytesSent << "\n";
+
+            total.restarts += stats.restarts;
+            total.accepted += stats.accepted;
+            total.active += stats.active;
+            total.requests += stats.requests;
+            total.bytesSent += stats.bytesSent;
+        }
+
+        std::ostringstream report;
+        report << "processes " << _processes << " restarts " << total.restarts
+               << " accepted " << total.accepted << " active " << total.active
+               << " requests " << total.requests;
+        for (int j = 0; j < 5; ++j) {
+            report << ' ' << j + 1 << "xx " << total.responses[j];
+        }
+        report << " bytes " << total.bytesSent << "\n" << lines.str();
+        return report.str();
+    }
+}
\ No newline at end of file
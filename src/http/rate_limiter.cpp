@@ -0,0 +1,210 @@
+#include <sys/socket.h>
+#include <time.h>
+
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "../../include/http/rate_limiter.h"
+
+namespace httpserver {
+
+    namespace {
+        std::int64_t NowNs() {
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+            return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+        }
+
+        // FNV-1a, zero is reserved for empty buckets
+        std::uint64_t Hash(const std::uint8_t* data, size_t length, std::uint64_t seed) {
+            std::uint64_t hash = 14695981039346656037ULL ^ seed;
+            for (size_t i = 0; i < length; ++i) {
+                hash ^= data[i];
+                hash *= 1099511628211ULL;
+            }
+            return hash ? hash : 1;
+        }
+    }
+
+    RateLimiter::RateLimiter(const RateLimitConfig& config) :
+        _config(config),
+        _running(false) {
+        if (config.requestsPerSecond <= 0.0 || config.burst < 1.0) {
+            throw std::invalid_argument("Rate limit needs a positive rate and a burst of at least 1");
+        }
+        if (config.mode == RateLimitMode::Accept && config.key == RateLimitKey::Header) {
+            throw std::invalid_argument("Header keys need parsing and cannot be limited at accept time");
+        }
+
+        for (int i = 0; i < SHARD_COUNT; ++i) {
+            _shards[i].buckets.reset(new Bucket[config::RATE_LIMIT_TABLE_SIZE]);
+            _shards[i].rejected = 0;
+            for (size_t j = 0; j < config::RATE_LIMIT_TABLE_SIZE; ++j) {
+                Bucket& bucket = _shards[i].buckets[j];
+                bucket.key = 0;
+                bucket.consumed = 0;
+                bucket.foreign = 0;
+                bucket.appliedForeign = 0;
+                bucket.tokens = 0.0;
+                bucket.lastRefill = 0;
+            }
+        }
+        _previousKeys.resize(SHARD_COUNT * config::RATE_LIMIT_TABLE_SIZE);
+        _previousConsumed.resize(SHARD_COUNT * config::RATE_LIMIT_TABLE_SIZE);
+        _deltas.resize(SHARD_COUNT * config::RATE_LIMIT_TABLE_SIZE);
+
+        // Retry once a full token has been refilled
+        long retryAfter = static_cast<long>(std::ceil(1.0 / config.requestsPerSecond));
+        _rejection = "HTTP/1.1 429 Too Many Requests\r\nContent-Length: 0\r\nRetry-After: " +
+                     std::to_string(retryAfter < 1 ? 1 : retryAfter) + "\r\n\r\n";
+    }
+
+    RateLimiter::~RateLimiter() {
+        Stop();
+    }
+
+    void RateLimiter::Start() {
+        _running = true;
+        _reconcilerThread = std::thread(&RateLimiter::Run, this);
+    }
+
+    void RateLimiter::Stop() {
+        _running = false;
+        if (_reconcilerThread.joinable()) {
+            _reconcilerThread.join();
+        }
+    }
+
+    bool RateLimiter::Allow(int shardIndex, std::uint64_t key) {
+        Shard& shard = _shards[shardIndex];
+        std::int64_t now = NowNs();
+        Bucket& bucket = FindBucket(shard, key, now);
+
+        // Refill at the global rate, then pay for what other shards consumed since the last check
+        double elapsed = static_cast<double>(now - bucket.lastRefill) / 1e9;
+        bucket.lastRefill = now;
+        bucket.tokens += elapsed * _config.requestsPerSecond;
+        if (bucket.tokens > _config.burst) {
+            bucket.tokens = _config.burst;
+        }
+        std::uint64_t foreign = bucket.foreign.load(std::memory_order_relaxed);
+        bucket.tokens -= static_cast<double>(foreign - bucket.appliedForeign);
+        bucket.appliedForeign = foreign;
+
+        if (bucket.tokens < 1.0) {
+            shard.rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        bucket.tokens -= 1.0;
+        bucket.consumed.store(bucket.consumed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    RateLimiter::Bucket& RateLimiter::FindBucket(Shard& shard, std::uint64_t key, std::int64_t now) {
+        const size_t mask = config::RATE_LIMIT_TABLE_SIZE - 1;
+        Bucket* victim = nullptr;
+
+        for (size_t i = 0; i < config::RATE_LIMIT_PROBE_LENGTH; ++i) {
+            Bucket& bucket = shard.buckets[(key + i) & mask];
+            std::uint64_t current = bucket.key.load(std::memory_order_relaxed);
+            if (current == key) {
+                return bucket;
+            }
+            if (current == 0) {
+                victim = &bucket;
+                break;
+            }
+            if (victim == nullptr || bucket.lastRefill < victim->lastRefill) {
+                victim = &bucket;
+            }
+        }
+
+        // Claim an empty slot or evict the least recently used one in the probe window
+        victim->key.store(key, std::memory_order_relaxed);
+        victim->consumed.store(0, std::memory_order_relaxed);
+        victim->appliedForeign = victim->foreign.load(std::memory_order_relaxed);
+        victim->tokens = _config.burst;
+        victim->lastRefill = now;
+        return *victim;
+    }
+
+    std::uint64_t RateLimiter::KeyFor(const PeerAddress& peer) const {
+        std::uint8_t masked[17] = {peer.family};
+        size_t length = peer.family == AF_INET6 ? 16 : 4;
+        int prefix = peer.family == AF_INET6 ? _config.ipv6PrefixLength : _config.ipv4PrefixLength;
+
+        for (size_t i = 0; i < length; ++i) {
+            int bits = prefix - static_cast<int>(i) * 8;
+            std::uint8_t byteMask = bits >= 8 ? 0xFF : (bits <= 0 ? 0 : static_cast<std::uint8_t>(0xFF << (8 - bits)));
+            masked[i + 1] = peer.address[i] & byteMask;
+        }
+        return Hash(masked, length + 1, 0);
+    }
+
+    std::uint64_t RateLimiter::KeyFor(StringView value) const {
+        return Hash(reinterpret_cast<const std::uint8_t*>(value.Data()), value.Length(), 0x68656164);
+    }
+
+    const RateLimitConfig& RateLimiter::GetConfig() const {
+        return _config;
+    }
+
+    StringView RateLimiter::GetRejection() const {
+        return StringView(_rejection);
+    }
+
+    std::uint64_t RateLimiter::GetRejectedCount() const {
+        std::uint64_t rejected = 0;
+        for (int i = 0; i < SHARD_COUNT; ++i) {
+            rejected += _shards[i].rejected.load(std::memory_order_relaxed);
+        }
+        return rejected;
+    }
+
+    void RateLimiter::Reconcile() {
+        // Consumption since the previous pass, summed per key over all shards
+        std::unordered_map<std::uint64_t, std::uint64_t> totals;
+        for (int i = 0; i < SHARD_COUNT; ++i) {
+            for (size_t j = 0; j < config::RATE_LIMIT_TABLE_SIZE; ++j) {
+                const Bucket& bucket = _shards[i].buckets[j];
+                size_t slot = i * config::RATE_LIMIT_TABLE_SIZE + j;
+                std::uint64_t key = bucket.key.load(std::memory_order_relaxed);
+                std::uint64_t consumed = bucket.consumed.load(std::memory_order_relaxed);
+
+                // A reclaimed slot restarts its counter from zero
+                if (key != _previousKeys[slot] || consumed < _previousConsumed[slot]) {
+                    _previousConsumed[slot] = 0;
+                }
+                _deltas[slot] = consumed - _previousConsumed[slot];
+                _previousKeys[slot] = key;
+                _previousConsumed[slot] = consumed;
+                if (key != 0 && _deltas[slot] != 0) {
+                    totals[key] += _deltas[slot];
+                }
+            }
+        }
+
+        // Charge every bucket with what the other shards took for its key
+        for (int i = 0; i < SHARD_COUNT; ++i) {
+            for (size_t j = 0; j < config::RATE_LIMIT_TABLE_SIZE; ++j) {
+                Bucket& bucket = _shards[i].buckets[j];
+                size_t slot = i * config::RATE_LIMIT_TABLE_SIZE + j;
+                if (_previousKeys[slot] == 0) continue;
+                auto it = totals.find(_previousKeys[slot]);
+                if (it == totals.end() || it->second == _deltas[slot]) continue;
+                std::uint64_t others = it->second - _deltas[slot];
+                bucket.foreign.store(bucket.foreign.load(std::memory_order_relaxed) + others, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void RateLimiter::Run() {
+        while (_running) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(config::RATE_LIMIT_RECONCILE_INTERVAL));
+            Reconcile();
+        }
+    }
+
+}
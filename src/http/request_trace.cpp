@@ -0,0 +1,314 @@
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+#include "../../include/http/http_message.h"
+#include "../../include/http/request_trace.h"
+#include "../../include/utils/serialize.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HTTPSERVER_TRACE_TSC 1
+#include <x86intrin.h>
+#endif
+
+namespace httpserver {
+
+    namespace {
+        constexpr std::uint64_t ALWAYS_SAMPLE = std::uint64_t(1) << 32;
+        const char* const kPhaseNames[TRACE_PHASE_COUNT] = {"queue", "parse", "handle", "serialize", "send"};
+
+        int BucketFor(std::uint64_t nanoseconds) {
+            if (nanoseconds == 0) return 0;
+            int bucket = 64 - __builtin_clzll(nanoseconds);
+            return bucket < config::TRACE_HISTOGRAM_BUCKETS ? bucket : config::TRACE_HISTOGRAM_BUCKETS - 1;
+        }
+
+        // Bucket b holds durations below 2^b nanoseconds
+        double BucketUpperBoundUs(int bucket) {
+            return static_cast<double>(std::uint64_t(1) << bucket) / 1000.0;
+        }
+
+        std::uint32_t Saturate(std::uint64_t value) {
+            return value > UINT32_MAX ? UINT32_MAX : static_cast<std::uint32_t>(value);
+        }
+
+        const char* MethodName(std::uint8_t method, std::string& storage) {
+            if (method == RequestTraceRecord::METHOD_UNKNOWN) return "-";
+            storage = ToString(static_cast<HttpMethod>(method));
+            return storage.c_str();
+        }
+
+        void Appendf(std::string& out, const char* format, ...) __attribute__((format(printf, 2, 3)));
+        void Appendf(std::string& out, const char* format, ...) {
+            char line[256];
+            va_list args;
+            va_start(args, format);
+            int length = std::vsnprintf(line, sizeof(line), format, args);
+            va_end(args);
+            if (length > 0) out.append(line, std::min(static_cast<size_t>(length), sizeof(line) - 1));
+        }
+
+        void AppendJsonString(std::string& out, const char* data, size_t length) {
+            out += '"';
+            for (size_t i = 0; i < length; ++i) {
+                unsigned char c = static_cast<unsigned char>(data[i]);
+                if (c == '"' || c == '\\') {
+                    out += '\\';
+                    out += static_cast<char>(c);
+                } else if (c < 0x20 || c >= 0x7F) {
+                    Appendf(out, "\\u%04x", c);
+                } else {
+                    out += static_cast<char>(c);
+                }
+            }
+            out += '"';
+        }
+
+        bool SlowerThan(const RequestTraceRecord& lhs, const RequestTraceRecord& rhs) {
+            return lhs.totalNs > rhs.totalNs;
+        }
+    }
+
+    RequestTracer::RequestTracer(double sampleRate) :
+        _sampleRate(std::min(std::max(sampleRate, 0.0), 1.0)),
+        _threshold(static_cast<std::uint64_t>(_sampleRate * static_cast<double>(ALWAYS_SAMPLE))),
+        _epoch(0),
+        _nanosecondsPerTick(1.0) {
+        for (int i = 0; i < config::WORKER_POOL_SIZE; ++i) {
+            _rings[i].reset(new Ring());
+            _workers[i].reset(new WorkerState());
+            _workers[i]->randomState = 0x9E3779B97F4A7C15ULL * (i + 1);
+            _workers[i]->sampled = 0;
+            _workers[i]->dropped = 0;
+            for (auto& phase : _workers[i]->histogram) {
+                for (auto& bucket : phase) {
+                    bucket = 0;
+                }
+            }
+        }
+        _slowest.reserve(config::TRACE_SLOWEST_COUNT);
+
+#ifdef HTTPSERVER_TRACE_TSC
+        // Calibrate the TSC against the steady clock once, an invariant TSC is assumed
+        auto wallStart = std::chrono::steady_clock::now();
+        std::uint64_t tickStart = Now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        std::uint64_t ticks = Now() - tickStart;
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wallStart);
+        if (ticks > 0) {
+            _nanosecondsPerTick = static_cast<double>(elapsed.count()) / static_cast<double>(ticks);
+        }
+#endif
+        _epoch = Now();
+    }
+
+    std::uint64_t RequestTracer::Now() {
+#ifdef HTTPSERVER_TRACE_TSC
+        return __rdtsc();
+#else
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+        return static_cast<std::uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+#endif
+    }
+
+    bool RequestTracer::ShouldSample(int workerId) {
+        if (_threshold >= ALWAYS_SAMPLE) return true;
+        if (_threshold == 0) return false;
+
+        // xorshift64, state is private to the worker
+        std::uint64_t& state = _workers[workerId]->randomState;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return (state >> 32) < _threshold;
+    }
+
+    void RequestTracer::Record(int workerId, RequestTrace& trace) {
+        // Skipped phases, e.g. the handler after a parse error, are recorded as zero length
+        for (int i = 1; i <= TRACE_PHASE_COUNT; ++i) {
+            if (trace.marks[i] < trace.marks[i - 1]) {
+                trace.marks[i] = trace.marks[i - 1];
+            }
+        }
+
+        WorkerState& worker = *_workers[workerId];
+        RequestTraceRecord& record = trace.record;
+        record.workerId = static_cast<std::uint8_t>(workerId);
+        record.startNs = trace.marks[0] > _epoch ? ToNanoseconds(trace.marks[0] - _epoch) : 0;
+        record.totalNs = Saturate(ToNanoseconds(trace.marks[TRACE_PHASE_COUNT] - trace.marks[0]));
+        for (int phase = 0; phase < TRACE_PHASE_COUNT; ++phase) {
+            std::uint64_t nanoseconds = ToNanoseconds(trace.marks[phase + 1] - trace.marks[phase]);
+            record.phaseNs[phase] = Saturate(nanoseconds);
+            worker.histogram[phase][BucketFor(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        worker.sampled.fetch_add(1, std::memory_order_relaxed);
+        if (!_rings[workerId]->TryPush(record)) {
+            worker.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    std::string RequestTracer::FormatSummary() {
+        std::uint64_t counts[TRACE_PHASE_COUNT][config::TRACE_HISTOGRAM_BUCKETS];
+        MergeHistograms(counts);
+        std::vector<RequestTraceRecord> slowest = SortedSlowest();
+
+        std::string out;
+        Appendf(out, "sample rate %.4f, sampled %llu, dropped %llu\n\n", _sampleRate,
+                static_cast<unsigned long long>(GetSampledCount()),
+                static_cast<unsigned long long>(GetDroppedCount()));
+
+        // Percentiles are bucket upper bounds
+        Appendf(out, "%-10s %10s %10s %10s %10s %10s\n", "phase (us)", "count", "p50", "p90", "p99", "max");
+        for (int phase = 0; phase < TRACE_PHASE_COUNT; ++phase) {
+            std::uint64_t total = 0;
+            int highest = 0;
+            for (int bucket = 0; bucket < config::TRACE_HISTOGRAM_BUCKETS; ++bucket) {
+                total += counts[phase][bucket];
+                if (counts[phase][bucket] > 0) highest = bucket;
+            }
+
+            double percentiles[3] = {0, 0, 0};
+            const double ranks[3] = {0.50, 0.90, 0.99};
+            for (int p = 0; p < 3 && total > 0; ++p) {
+                std::uint64_t target = static_cast<std::uint64_t>(ranks[p] * static_cast<double>(total - 1)) + 1;
+                std::uint64_t seen = 0;
+                for (int bucket = 0; bucket < config::TRACE_HISTOGRAM_BUCKETS; ++bucket) {
+                    seen += counts[phase][bucket];
+                    if (seen >= target) {
+                        percentiles[p] = BucketUpperBoundUs(bucket);
+                        break;
+                    }
+                }
+            }
+            Appendf(out, "%-10s %10llu %10.1f %10.1f %10.1f %10.1f\n", kPhaseNames[phase],
+                    static_cast<unsigned long long>(total), percentiles[0], percentiles[1], percentiles[2],
+                    total > 0 ? BucketUpperBoundUs(highest) : 0.0);
+        }
+
+        Appendf(out, "\nslowest %zu requests (us)\n", slowest.size());
+        Appendf(out, "%9s %9s %9s %9s %9s %9s %5s %6s %6s %-7s %s\n", "total", "queue", "parse", "handle",
+                "serialize", "send", "sends", "status", "worker", "method", "path");
+        std::string method;
+        for (const RequestTraceRecord& record : slowest) {
+            Appendf(out, "%9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %5u %6u %6u %-7s %.*s\n",
+                    record.totalNs / 1000.0, record.phaseNs[0] / 1000.0, record.phaseNs[1] / 1000.0,
+                    record.phaseNs[2] / 1000.0, record.phaseNs[3] / 1000.0, record.phaseNs[4] / 1000.0,
+                    record.sendCalls, record.status, record.workerId, MethodName(record.method, method),
+                    static_cast<int>(record.pathLength), record.path);
+        }
+        return out;
+    }
+
+    std::string RequestTracer::FormatChromeTrace() {
+        std::uint64_t counts[TRACE_PHASE_COUNT][config::TRACE_HISTOGRAM_BUCKETS];
+        MergeHistograms(counts);
+        std::vector<RequestTraceRecord> slowest = SortedSlowest();
+
+        // One track per worker, each request is a span with its phases nested below it
+        std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        for (int worker = 0; worker < config::WORKER_POOL_SIZE; ++worker) {
+            Appendf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}}",
+                    first ? "" : ",", worker, worker);
+            first = false;
+        }
+
+        std::string method;
+        for (const RequestTraceRecord& record : slowest) {
+            double start = record.startNs / 1000.0;
+            Appendf(out, ",{\"name\":");
+            std::string name = MethodName(record.method, method);
+            name += ' ';
+            name.append(record.path, record.pathLength);
+            AppendJsonString(out, name.data(), name.length());
+            Appendf(out, ",\"cat\":\"request\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+                    "\"args\":{\"status\":%u,\"sends\":%u}}",
+                    record.workerId, start, record.totalNs / 1000.0, record.status, record.sendCalls);
+
+            for (int phase = 0; phase < TRACE_PHASE_COUNT; ++phase) {
+                Appendf(out, ",{\"name\":\"%s\",\"cat\":\"phase\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                        kPhaseNames[phase], record.workerId, start, record.phaseNs[phase] / 1000.0);
+                start += record.phaseNs[phase] / 1000.0;
+            }
+        }
+        out += "],\"histograms\":{\"bucketUpperBoundsNs\":[";
+        for (int bucket = 0; bucket < config::TRACE_HISTOGRAM_BUCKETS; ++bucket) {
+            Appendf(out, "%s%llu", bucket == 0 ? "" : ",", 1ULL << bucket);
+        }
+        out += ']';
+        for (int phase = 0; phase < TRACE_PHASE_COUNT; ++phase) {
+            Appendf(out, ",\"%s\":[", kPhaseNames[phase]);
+            for (int bucket = 0; bucket < config::TRACE_HISTOGRAM_BUCKETS; ++bucket) {
+                Appendf(out, "%s%llu", bucket == 0 ? "" : ",", static_cast<unsigned long long>(counts[phase][bucket]));
+            }
+            out += ']';
+        }
+        out += "}}\n";
+        return out;
+    }
+
+    std::uint64_t RequestTracer::GetSampledCount() const {
+        std::uint64_t total = 0;
+        for (const auto& worker : _workers) {
+            total += worker->sampled.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    std::uint64_t RequestTracer::GetDroppedCount() const {
+        std::uint64_t total = 0;
+        for (const auto& worker : _workers) {
+            total += worker->dropped.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    std::uint64_t RequestTracer::ToNanoseconds(std::uint64_t ticks) const {
+        return static_cast<std::uint64_t>(static_cast<double>(ticks) * _nanosecondsPerTick);
+    }
+
+    void RequestTracer::Drain() {
+        // The lock makes this the only consumer of every ring
+        RequestTraceRecord record;
+        for (auto& ring : _rings) {
+            while (ring->TryPop(&record)) {
+                if (_slowest.size() < config::TRACE_SLOWEST_COUNT) {
+                    _slowest.push_back(record);
+                    std::push_heap(_slowest.begin(), _slowest.end(), SlowerThan);
+                } else if (record.totalNs > _slowest.front().totalNs) {
+                    std::pop_heap(_slowest.begin(), _slowest.end(), SlowerThan);
+                    _slowest.back() = record;
+                    std::push_heap(_slowest.begin(), _slowest.end(), SlowerThan);
+                }
+            }
+        }
+    }
+
+    std::vector<RequestTraceRecord> RequestTracer::SortedSlowest() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Drain();
+        std::vector<RequestTraceRecord> slowest = _slowest;
+        std::sort(slowest.begin(), slowest.end(), SlowerThan);
+        return slowest;
+    }
+
+    void RequestTracer::MergeHistograms(std::uint64_t counts[TRACE_PHASE_COUNT][config::TRACE_HISTOGRAM_BUCKETS]) const {
+        for (int phase = 0; phase < TRACE_PHASE_COUNT; ++phase) {
+            for (int bucket = 0; bucket < config::TRACE_HISTOGRAM_BUCKETS; ++bucket) {
+                counts[phase][bucket] = 0;
+                for (const auto& worker : _workers) {
+                    counts[phase][bucket] += worker->histogram[phase][bucket].load(std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,196 @@
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include <cerrno>
+#include <climits>
+#include <stdexcept>
+
+#include "../../include/http/tls.h"
+
+namespace httpserver {
+
+    namespace {
+        std::string WithOpenSslError(const std::string& message) {
+            unsigned long code = ERR_get_error();
+            ERR_clear_error();
+            if (code == 0) {
+                return message;
+            }
+            char detail[256];
+            ERR_error_string_n(code, detail, sizeof(detail));
+            return message + ": " + detail;
+        }
+
+        int ClampLength(size_t length) {
+            return length > INT_MAX ? INT_MAX : static_cast<int>(length);
+        }
+    }
+
+    TlsContext::TlsContext(const TlsConfig& config) :
+        _config(config),
+        _context(SSL_CTX_new(TLS_server_method())),
+        _handshakes(0),
+        _resumed(0),
+        _failed(0),
+        _kernelSend(0),
+        _kernelReceive(0) {
+        if (_context == nullptr) {
+            throw std::runtime_error(WithOpenSslError("Failed to create TLS context"));
+        }
+
+        auto fail = [this](const std::string& message) {
+            std::string error = WithOpenSslError(message);
+            SSL_CTX_free(_context);
+            _context = nullptr;
+            throw std::runtime_error(error);
+        };
+
+        if (SSL_CTX_use_certificate_chain_file(_context, config.certificateFile.c_str()) != 1) {
+            fail("Failed to load TLS certificate " + config.certificateFile);
+        }
+        if (SSL_CTX_use_PrivateKey_file(_context, config.privateKeyFile.c_str(), SSL_FILETYPE_PEM) != 1 ||
+            SSL_CTX_check_private_key(_context) != 1) {
+            fail("Failed to load TLS private key " + config.privateKeyFile);
+        }
+
+        SSL_CTX_set_min_proto_version(_context, TLS1_2_VERSION);
+        // Send retries after EAGAIN may come from the overflow string, and may complete partially like send
+        SSL_CTX_set_mode(_context, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+        // Tickets carry the whole session, so there is no server side cache for workers to contend on
+        SSL_CTX_set_session_cache_mode(_context, SSL_SESS_CACHE_OFF);
+        if (!config.sessionTickets) {
+            SSL_CTX_set_options(_context, SSL_OP_NO_TICKET);
+            SSL_CTX_set_num_tickets(_context, 0);
+        }
+
+        // OpenSSL only switches when the kernel has the tls module and supports the negotiated cipher
+        if (config.kernelTls) {
+            SSL_CTX_set_options(_context, SSL_OP_ENABLE_KTLS);
+        }
+    }
+
+    TlsContext::~TlsContext() {
+        SSL_CTX_free(_context);
+    }
+
+    const TlsConfig& TlsContext::GetConfig() const {
+        return _config;
+    }
+
+    TlsStats TlsContext::GetStats() const {
+        TlsStats stats;
+        stats.handshakes = _handshakes.load(std::memory_order_relaxed);
+        stats.resumed = _resumed.load(std::memory_order_relaxed);
+        stats.failed = _failed.load(std::memory_order_relaxed);
+        stats.kernelSend = _kernelSend.load(std::memory_order_relaxed);
+        stats.kernelReceive = _kernelReceive.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    TlsSession::TlsSession(TlsContext& context, int fd) :
+        _context(context),
+        _ssl(SSL_new(context._context)),
+        _established(false),
+        _failed(false),
+        _kernelSend(false),
+        _kernelReceive(false) {
+        if (_ssl == nullptr || SSL_set_fd(_ssl, fd) != 1) {
+            SSL_free(_ssl);
+            throw std::runtime_error(WithOpenSslError("Failed to create TLS session"));
+        }
+        SSL_set_accept_state(_ssl);
+    }
+
+    TlsSession::~TlsSession() {
+        if (_established && !_failed) {
+            // Best effort close_notify, the socket is closed right after
+            SSL_shutdown(_ssl);
+            ERR_clear_error();
+        }
+        SSL_free(_ssl);
+    }
+
+    TlsHandshakeStatus TlsSession::Handshake() {
+        ERR_clear_error();
+        int result = SSL_do_handshake(_ssl);
+        if (result == 1) {
+            _established = true;
+            _kernelSend = BIO_get_ktls_send(SSL_get_wbio(_ssl));
+            _kernelReceive = BIO_get_ktls_recv(SSL_get_rbio(_ssl));
+            _context._handshakes.fetch_add(1, std::memory_order_relaxed);
+            if (IsResumed()) _context._resumed.fetch_add(1, std::memory_order_relaxed);
+            if (_kernelSend) _context._kernelSend.fetch_add(1, std::memory_order_relaxed);
+            if (_kernelReceive) _context._kernelReceive.fetch_add(1, std::memory_order_relaxed);
+            return TlsHandshakeStatus::Done;
+        }
+
+        switch (SSL_get_error(_ssl, result)) {
+            case SSL_ERROR_WANT_READ:
+                return TlsHandshakeStatus::WantRead;
+            case SSL_ERROR_WANT_WRITE:
+                return TlsHandshakeStatus::WantWrite;
+            default:
+                _failed = true;
+                ERR_clear_error();
+                _context._failed.fetch_add(1, std::memory_order_relaxed);
+                return TlsHandshakeStatus::Failed;
+        }
+    }
+
+    bool TlsSession::IsEstablished() const {
+        return _established;
+    }
+
+    ssize_t TlsSession::Read(char* buffer, size_t length) {
+        ERR_clear_error();
+        int result = SSL_read(_ssl, buffer, ClampLength(length));
+        return result > 0 ? result : Fail(result);
+    }
+
+    ssize_t TlsSession::Write(const char* buffer, size_t length) {
+        ERR_clear_error();
+        int result = SSL_write(_ssl, buffer, ClampLength(length));
+        if (result > 0) {
+            return result;
+        }
+        if (Fail(result) == 0) {
+            errno = EPIPE;
+        }
+        return -1;
+    }
+
+    bool TlsSession::HasPending() const {
+        return SSL_pending(_ssl) > 0;
+    }
+
+    bool TlsSession::IsResumed() const {
+        return SSL_session_reused(_ssl) == 1;
+    }
+
+    bool TlsSession::IsKernelSend() const {
+        return _kernelSend;
+    }
+
+    bool TlsSession::IsKernelReceive() const {
+        return _kernelReceive;
+    }
+
+    ssize_t TlsSession::Fail(int result) {
+        switch (SSL_get_error(_ssl, result)) {
+            case SSL_ERROR_ZERO_RETURN:
+                // The peer sent close_notify
+                return 0;
+            case SSL_ERROR_WANT_READ:
+            case SSL_ERROR_WANT_WRITE:
+                errno = EAGAIN;
+                return -1;
+            default:
+                _failed = true;
+                ERR_clear_error();
+                errno = ECONNRESET;
+                return -1;
+        }
+    }
+}
\ No newline at end of file
@@ -1,6 +1,4 @@
 #include "../../include/http/uri.h"
-#include <algorithm>
-#include <cctype>
 
 namespace httpserver {
 
@@ -17,17 +15,14 @@ namespace httpserver {
         return _query < other._query;
     }
 
-    void URI::Parse(std::string uri) {
-        std::transform(uri.begin(), uri.end(), uri.begin(), [](unsigned char c) {
-            return std::tolower(c);
-        });
-
+    void URI::Parse(const std::string& uri) {
         size_t queryPos = uri.find('?');
         if (queryPos != std::string::npos) {
             _path = uri.substr(0, queryPos);
             _query = uri.substr(queryPos + 1);
         } else {
             _path = uri;
+            _query.clear();
         }
 
         if (_path.empty() || _path[0] != '/') {
@@ -35,11 +30,11 @@ namespace httpserver {
         }
     }
 
-    std::string URI::GetPath() const {
+    const std::string& URI::GetPath() const {
         return _path;
     }
 
-    std::string URI::GetQuery() const {
+    const std::string& URI::GetQuery() const {
         return _query;
     }
 
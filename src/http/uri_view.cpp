@@ -0,0 +1,284 @@
+#include "../../include/http/uri_view.h"
+
+namespace httpserver {
+
+    namespace {
+        int HexValue(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        // Decodes one character at input[pos] and advances pos, malformed escapes are kept literally
+        char DecodeAt(StringView input, size_t& pos, bool plusAsSpace) {
+            char c = input[pos++];
+            if (c == '%' && pos + 2 <= input.Length()) {
+                int high = HexValue(input[pos]);
+                int low = HexValue(input[pos + 1]);
+                if (high >= 0 && low >= 0) {
+                    pos += 2;
+                    return static_cast<char>((high << 4) | low);
+                }
+            } else if (c == '+' && plusAsSpace) {
+                return ' ';
+            }
+            return c;
+        }
+
+        // Compares an encoded query key against a plain key without materializing the decoded key
+        bool DecodedEquals(StringView encoded, StringView plain) {
+            // Decoding never lengthens, and plain keys compare directly when nothing is escaped
+            if (encoded.Length() < plain.Length()) return false;
+            if (encoded.Length() == plain.Length() &&
+                encoded.Find('%') == StringView::npos && encoded.Find('+') == StringView::npos) {
+                return encoded == plain;
+            }
+            size_t pos = 0, plainPos = 0;
+            while (pos < encoded.Length()) {
+                if (plainPos == plain.Length() || DecodeAt(encoded, pos, true) != plain[plainPos]) {
+                    return false;
+                }
+                ++plainPos;
+            }
+            return plainPos == plain.Length();
+        }
+
+        // 1 for ".", 2 for "..", 0 for anything else. Dots may be percent-encoded, "%2e%2e" is still ".."
+        int DotSegment(StringView segment) {
+            if (segment.Empty() || segment.Length() > 6) return 0;
+            int dots = 0;
+            for (size_t pos = 0; pos < segment.Length();) {
+                if (DecodeAt(segment, pos, false) != '.') return 0;
+                ++dots;
+            }
+            return dots <= 2 ? dots : 0;
+        }
+
+        // An encoded slash stays %2F, so it can neither split a segment nor climb out of one
+        void AppendDecodedSegment(StringView segment, ArenaString& out) {
+            for (size_t pos = 0; pos < segment.Length();) {
+                char c = DecodeAt(segment, pos, false);
+                if (c == '/') {
+                    out.append("%2F", 3);
+                } else {
+                    out += c;
+                }
+            }
+        }
+
+        bool NeedsNormalization(StringView path) {
+            if (path.Empty() || path[0] != '/') return true;
+            for (size_t i = 0; i < path.Length(); ++i) {
+                if (path[i] == '%') return true;
+                if (path[i] == '.' && path[i - 1] == '/') return true;
+            }
+            return false;
+        }
+    }
+
+    URIView::URIView() :
+        _pathNormalized(false),
+        _queryIndexed(false),
+        _queryOverflow(false),
+        _queryParamCount(0),
+        _queryIndexEnd(0) {}
+
+    URIView::URIView(const char* data, size_t length) : URIView() {
+        Parse(data, length);
+    }
+
+    void URIView::Parse(const char* data, size_t length) {
+        _raw = StringView(data, length);
+        _pathNormalized = false;
+        _queryIndexed = false;
+        _queryOverflow = false;
+        _queryParamCount = 0;
+        _queryIndexEnd = 0;
+        _normalizedPath.clear();
+
+        StringView target = _raw.Substr(0, _raw.Find('#'));
+
+        // Absolute-form targets carry a scheme and authority before the path
+        size_t start = 0;
+        if (!target.Empty() && target[0] != '/') {
+            size_t schemeEnd = target.Find(':');
+            if (schemeEnd != StringView::npos && target.Substr(schemeEnd, 3) == "://") {
+                start = target.Find('/', schemeEnd + 3);
+                if (start == StringView::npos) start = target.Length();
+                size_t queryInAuthority = target.Find('?', schemeEnd + 3);
+                if (queryInAuthority < start) start = queryInAuthority;
+            }
+        }
+
+        size_t queryPos = target.Find('?', start);
+        if (queryPos != StringView::npos) {
+            _path = target.Substr(start, queryPos - start);
+            _query = target.Substr(queryPos + 1);
+        } else {
+            _path = target.Substr(start);
+            _query = StringView();
+        }
+    }
+
+    StringView URIView::GetRaw() const {
+        return _raw;
+    }
+
+    StringView URIView::GetRawPath() const {
+        return _path;
+    }
+
+    StringView URIView::GetRawQuery() const {
+        return _query;
+    }
+
+    StringView URIView::GetPath() const {
+        if (!_pathNormalized) {
+            NormalizePath();
+        }
+        return _normalizedPath.empty() ? _path : StringView(_normalizedPath);
+    }
+
+    void URIView::NormalizePath() const {
+        _pathNormalized = true;
+        if (!NeedsNormalization(_path)) {
+            return;
+        }
+
+        // Remove dot segments (RFC 3986, section 5.2.4) on the raw path split at literal slashes, then
+        // decode each segment on its own. Decoding first would turn "..%2F" into a real parent step.
+        _normalizedPath.reserve(_path.Length() + 1);
+        size_t segmentStart = !_path.Empty() && _path[0] == '/' ? 1 : 0;
+        for (;;) {
+            size_t segmentEnd = _path.Find('/', segmentStart);
+            bool last = segmentEnd == StringView::npos;
+            if (last) segmentEnd = _path.Length();
+            StringView segment = _path.Substr(segmentStart, segmentEnd - segmentStart);
+
+            int dots = DotSegment(segment);
+            if (dots == 1) {
+                if (last) _normalizedPath += '/';
+            } else if (dots == 2) {
+                size_t parent = _normalizedPath.rfind('/');
+                _normalizedPath.erase(parent == ArenaString::npos ? 0 : parent);
+                if (last) _normalizedPath += '/';
+            } else {
+                _normalizedPath += '/';
+                AppendDecodedSegment(segment, _normalizedPath);
+            }
+            if (last) break;
+            segmentStart = segmentEnd + 1;
+        }
+        if (_normalizedPath.empty()) {
+            _normalizedPath = "/";
+        }
+    }
+
+    void URIView::IndexQuery() const {
+        _queryIndexed = true;
+        size_t pos = 0;
+        if (_query.Length() > UINT32_MAX) {
+            // Too long for the offsets, every lookup scans instead
+            _queryOverflow = true;
+            _queryIndexEnd = 0;
+            return;
+        }
+        while (pos < _query.Length()) {
+            size_t end = _query.Find('&', pos);
+            if (end == StringView::npos) end = _query.Length();
+
+            if (end > pos) {
+                if (_queryParamCount == config::MAX_QUERY_PARAMS) {
+                    _queryOverflow = true;
+                    break;
+                }
+                size_t equals = _query.Substr(0, end).Find('=', pos);
+                QueryParam& param = _queryParams[_queryParamCount++];
+                param.keyOffset = static_cast<std::uint32_t>(pos);
+                if (equals == StringView::npos) {
+                    param.keyLength = static_cast<std::uint32_t>(end - pos);
+                    param.valueOffset = static_cast<std::uint32_t>(end);
+                    param.valueLength = 0;
+                } else {
+                    param.keyLength = static_cast<std::uint32_t>(equals - pos);
+                    param.valueOffset = static_cast<std::uint32_t>(equals + 1);
+                    param.valueLength = static_cast<std::uint32_t>(end - equals - 1);
+                }
+            }
+            pos = end + 1;
+        }
+        _queryIndexEnd = pos;
+    }
+
+    bool URIView::ScanQuery(size_t from, StringView key, StringView* value) const {
+        size_t pos = from;
+        while (pos < _query.Length()) {
+            size_t end = _query.Find('&', pos);
+            if (end == StringView::npos) end = _query.Length();
+            StringView pair = _query.Substr(pos, end - pos);
+            size_t equals = pair.Find('=');
+            if (DecodedEquals(pair.Substr(0, equals), key)) {
+                if (value) *value = equals == StringView::npos ? StringView() : pair.Substr(equals + 1);
+                return true;
+            }
+            pos = end + 1;
+        }
+        return false;
+    }
+
+    bool URIView::FindQueryParam(StringView key, StringView* value) const {
+        if (!_queryIndexed) {
+            IndexQuery();
+        }
+        for (size_t i = 0; i < _queryParamCount; ++i) {
+            const QueryParam& param = _queryParams[i];
+            if (DecodedEquals(_query.Substr(param.keyOffset, param.keyLength), key)) {
+                if (value) *value = _query.Substr(param.valueOffset, param.valueLength);
+                return true;
+            }
+        }
+        // Parameters past the index capacity are still reachable, just not in constant space
+        return _queryOverflow && ScanQuery(_queryIndexEnd, key, value);
+    }
+
+    std::string URIView::GetQueryParam(StringView key) const {
+        StringView value;
+        return FindQueryParam(key, &value) ? PercentDecode(value, true) : std::string();
+    }
+
+    bool URIView::HasQueryParam(StringView key) const {
+        return FindQueryParam(key, nullptr);
+    }
+
+    size_t URIView::GetQueryParamCount() const {
+        if (!_queryIndexed) {
+            IndexQuery();
+        }
+        if (!_queryOverflow) {
+            return _queryParamCount;
+        }
+        size_t count = _queryParamCount;
+        for (size_t pos = _queryIndexEnd; pos < _query.Length();) {
+            size_t end = _query.Find('&', pos);
+            if (end == StringView::npos) end = _query.Length();
+            if (end > pos) ++count;
+            pos = end + 1;
+        }
+        return count;
+    }
+
+    bool URIView::IsValid() const {
+        return _raw.Data() != nullptr && !_raw.Empty();
+    }
+
+    std::string URIView::PercentDecode(StringView input, bool plusAsSpace) {
+        std::string decoded;
+        decoded.reserve(input.Length());
+        for (size_t pos = 0; pos < input.Length();) {
+            decoded += DecodeAt(input, pos, plusAsSpace);
+        }
+        return decoded;
+    }
+
+}
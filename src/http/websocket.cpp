@@ -0,0 +1,535 @@
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "../../include/http/websocket.h"
+#include "../../include/utils/base64.h"
+#include "../../include/utils/scan.h"
+#include "../../include/utils/sha1.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HTTPSERVER_MASK_X86 1
+#include <immintrin.h>
+#endif
+
+namespace httpserver {
+
+    namespace {
+        const char kWebSocketGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+        constexpr size_t MAX_CONTROL_PAYLOAD = 125;
+
+        void MaskScalar(char* data, size_t length, const std::uint8_t maskKey[4], size_t offset) {
+            for (size_t i = 0; i < length; ++i) {
+                data[i] ^= static_cast<char>(maskKey[(offset + i) & 3]);
+            }
+        }
+
+#ifdef HTTPSERVER_MASK_X86
+        // Key bytes rotated so that lane 0 lines up with data[0]
+        std::uint32_t RotatedKey(const std::uint8_t maskKey[4], size_t offset) {
+            std::uint8_t rotated[4];
+            for (size_t i = 0; i < 4; ++i) {
+                rotated[i] = maskKey[(offset + i) & 3];
+            }
+            std::uint32_t key;
+            std::memcpy(&key, rotated, sizeof(key));
+            return key;
+        }
+
+        __attribute__((target("sse2")))
+        void MaskSSE2(char* data, size_t length, const std::uint8_t maskKey[4], size_t offset) {
+            const __m128i key = _mm_set1_epi32(static_cast<int>(RotatedKey(maskKey, offset)));
+            size_t i = 0;
+            for (; i + 16 <= length; i += 16) {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_xor_si128(chunk, key));
+            }
+            MaskScalar(data + i, length - i, maskKey, offset + i);
+        }
+
+        __attribute__((target("avx2")))
+        void MaskAVX2(char* data, size_t length, const std::uint8_t maskKey[4], size_t offset) {
+            const __m256i key = _mm256_set1_epi32(static_cast<int>(RotatedKey(maskKey, offset)));
+            size_t i = 0;
+            for (; i + 32 <= length; i += 32) {
+                __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), _mm256_xor_si256(chunk, key));
+            }
+            _mm256_zeroupper();
+            MaskSSE2(data + i, length - i, maskKey, offset + i);
+        }
+#endif
+
+        using MaskFunction = void (*)(char*, size_t, const std::uint8_t*, size_t);
+
+        MaskFunction SelectMask() {
+#ifdef HTTPSERVER_MASK_X86
+            switch (scan::DetectIsa()) {
+                case scan::Isa::AVX2: return MaskAVX2;
+                case scan::Isa::SSE42: return MaskSSE2;
+                default: break;
+            }
+#endif
+            return MaskScalar;
+        }
+
+        bool IsValidUtf8(const char* data, size_t length) {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+            size_t i = 0;
+            while (i < length) {
+                // Skip ASCII eight bytes at a time
+                if (i + 8 <= length) {
+                    std::uint64_t word;
+                    std::memcpy(&word, bytes + i, sizeof(word));
+                    if ((word & 0x8080808080808080ULL) == 0) {
+                        i += 8;
+                        continue;
+                    }
+                }
+
+                unsigned char lead = bytes[i];
+                if (lead < 0x80) {
+                    ++i;
+                    continue;
+                }
+
+                size_t continuation;
+                std::uint32_t codePoint;
+                if (lead >= 0xC2 && lead <= 0xDF) {
+                    continuation = 1;
+                    codePoint = lead & 0x1F;
+                } else if ((lead & 0xF0) == 0xE0) {
+                    continuation = 2;
+                    codePoint = lead & 0x0F;
+                } else if (lead >= 0xF0 && lead <= 0xF4) {
+                    continuation = 3;
+                    codePoint = lead & 0x07;
+                } else {
+                    return false;
+                }
+
+                if (length - i <= continuation) return false;
+                for (size_t k = 1; k <= continuation; ++k) {
+                    unsigned char byte = bytes[i + k];
+                    if ((byte & 0xC0) != 0x80) return false;
+                    codePoint = (codePoint << 6) | (byte & 0x3F);
+                }
+
+                // Reject overlong forms, surrogates and code points past U+10FFFF
+                if (continuation == 2 && (codePoint < 0x800 || (codePoint >= 0xD800 && codePoint <= 0xDFFF))) {
+                    return false;
+                }
+                if (continuation == 3 && (codePoint < 0x10000 || codePoint > 0x10FFFF)) {
+                    return false;
+                }
+                i += continuation + 1;
+            }
+            return true;
+        }
+
+        bool IsValidCloseCode(std::uint16_t code) {
+            if (code >= 3000 && code <= 4999) return true;
+            switch (code) {
+                case 1000: case 1001: case 1002: case 1003: case 1007:
+                case 1008: case 1009: case 1010: case 1011:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+    }
+
+    size_t ParseWebSocketFrameHeader(const char* data, size_t length, WebSocketFrameHeader* header) {
+        if (length < 2) return 0;
+
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        header->fin = (bytes[0] & 0x80) != 0;
+        header->reserved = (bytes[0] & 0x70) != 0;
+        header->opcode = static_cast<WebSocketOpcode>(bytes[0] & 0x0F);
+        header->masked = (bytes[1] & 0x80) != 0;
+
+        size_t headerLength = 2;
+        std::uint64_t payloadLength = bytes[1] & 0x7F;
+        if (payloadLength == 126) {
+            if (length < 4) return 0;
+            payloadLength = (std::uint64_t(bytes[2]) << 8) | bytes[3];
+            headerLength = 4;
+        } else if (payloadLength == 127) {
+            if (length < 10) return 0;
+            payloadLength = 0;
+            for (size_t i = 2; i < 10; ++i) {
+                payloadLength = (payloadLength << 8) | bytes[i];
+            }
+            headerLength = 10;
+        }
+        header->payloadLength = payloadLength;
+
+        if (header->masked) {
+            if (length < headerLength + 4) return 0;
+            std::memcpy(header->maskKey, bytes + headerLength, 4);
+            headerLength += 4;
+        }
+        return headerLength;
+    }
+
+    WebSocketFrame MakeWebSocketFrame(WebSocketOpcode opcode, StringView payload) {
+        std::string frame;
+        size_t length = payload.Length();
+        frame.reserve(length + 10);
+
+        frame += static_cast<char>(0x80 | static_cast<std::uint8_t>(opcode));
+        if (length < 126) {
+            frame += static_cast<char>(length);
+        } else if (length <= 0xFFFF) {
+            frame += static_cast<char>(126);
+            frame += static_cast<char>(length >> 8);
+            frame += static_cast<char>(length & 0xFF);
+        } else {
+            frame += static_cast<char>(127);
+            for (int shift = 56; shift >= 0; shift -= 8) {
+                frame += static_cast<char>((std::uint64_t(length) >> shift) & 0xFF);
+            }
+        }
+        frame.append(payload.Data(), length);
+        return std::make_shared<const std::string>(std::move(frame));
+    }
+
+    void ApplyWebSocketMask(char* data, size_t length, const std::uint8_t maskKey[4], size_t offset) {
+        static const MaskFunction mask = SelectMask();
+        mask(data, length, maskKey, offset);
+    }
+
+    std::string ComputeWebSocketAccept(StringView key) {
+        std::string input = key.ToString();
+        input += kWebSocketGuid;
+
+        std::uint8_t digest[SHA1_DIGEST_SIZE];
+        Sha1(input.data(), input.size(), digest);
+        return Base64Encode(digest, sizeof(digest));
+    }
+
+    WebSocketConnection::WebSocketConnection(int fd, int epollFd, void* eventData, const WebSocketHandler* handler,
+                                             const std::string& path, const PeerAddress& peer, TlsSession* tls)
+        : _fd(fd), _epollFd(epollFd), _eventData(eventData), _tls(tls), _handler(handler), _path(path), _peer(peer),
+          _readLength(0), _messageOpcode(WebSocketOpcode::Text), _inMessage(false),
+          _queuedBytes(0), _wantWrite(false),
+          _opened(false), _closeSent(false), _broken(false), _closeCode(1006) {}
+
+    WebSocketConnection::~WebSocketConnection() {
+        if (_opened && _handler->onClose) {
+            // Nothing can be sent from here on
+            _closeSent = true;
+            _handler->onClose(*this, _closeCode);
+        }
+    }
+
+    void WebSocketConnection::SendText(StringView message) {
+        Send(MakeWebSocketFrame(WebSocketOpcode::Text, message));
+    }
+
+    void WebSocketConnection::SendBinary(StringView message) {
+        Send(MakeWebSocketFrame(WebSocketOpcode::Binary, message));
+    }
+
+    void WebSocketConnection::Send(const WebSocketFrame& frame) {
+        if (_closeSent || _broken) return;
+        Enqueue(frame);
+    }
+
+    void WebSocketConnection::Close(std::uint16_t code, StringView reason) {
+        if (_closeSent) return;
+
+        char payload[2 + MAX_CONTROL_PAYLOAD];
+        size_t reasonLength = reason.Length() < MAX_CONTROL_PAYLOAD - 2 ? reason.Length() : MAX_CONTROL_PAYLOAD - 2;
+        payload[0] = static_cast<char>(code >> 8);
+        payload[1] = static_cast<char>(code & 0xFF);
+        if (reasonLength > 0) std::memcpy(payload + 2, reason.Data(), reasonLength);
+
+        _closeCode = code;
+        SendClose(StringView(payload, 2 + reasonLength));
+    }
+
+    const std::string& WebSocketConnection::GetPath() const {
+        return _path;
+    }
+
+    const PeerAddress& WebSocketConnection::GetPeer() const {
+        return _peer;
+    }
+
+    bool WebSocketConnection::IsClosing() const {
+        return _closeSent || _broken;
+    }
+
+    void WebSocketConnection::Open() {
+        _opened = true;
+        if (_handler->onOpen) {
+            _handler->onOpen(*this);
+        }
+    }
+
+    void WebSocketConnection::OnReadable() {
+        if (_readBuffer.size() - _readLength < config::WEBSOCKET_READ_SIZE) {
+            _readBuffer.resize(_readLength + config::WEBSOCKET_READ_SIZE);
+        }
+
+        char* target = _readBuffer.data() + _readLength;
+        size_t space = _readBuffer.size() - _readLength;
+        ssize_t byteCount = _tls != nullptr ? _tls->Read(target, space) : recv(_fd, target, space, 0);
+        if (byteCount < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) _broken = true;
+            return;
+        }
+        if (byteCount == 0) {
+            _broken = true;
+            return;
+        }
+        _readLength += byteCount;
+
+        // Frames are unmasked in place once they are complete
+        char* buffer = _readBuffer.data();
+        size_t offset = 0;
+        while (!_closeSent && !_broken) {
+            WebSocketFrameHeader header;
+            size_t headerLength = ParseWebSocketFrameHeader(buffer + offset, _readLength - offset, &header);
+            if (headerLength == 0) break;
+
+            if (!header.masked) {
+                Fail(1002);
+                break;
+            }
+            if (header.payloadLength > config::WEBSOCKET_MAX_MESSAGE_SIZE) {
+                Fail(1009);
+                break;
+            }
+
+            size_t payloadLength = static_cast<size_t>(header.payloadLength);
+            if (_readLength - offset < headerLength + payloadLength) break;
+
+            char* payload = buffer + offset + headerLength;
+            ApplyWebSocketMask(payload, payloadLength, header.maskKey);
+            HandleFrame(header, payload, payloadLength);
+            offset += headerLength + payloadLength;
+        }
+
+        if (_closeSent) {
+            _readLength = 0;
+        } else if (offset > 0) {
+            std::memmove(buffer, buffer + offset, _readLength - offset);
+            _readLength -= offset;
+        }
+    }
+
+    void WebSocketConnection::OnWritable() {
+        Flush();
+        if (_queue.empty() && _wantWrite && !_broken) {
+            UpdateInterest(false);
+        }
+    }
+
+    bool WebSocketConnection::ShouldClose() const {
+        // The server closes the TCP connection as soon as its close frame is out
+        return _broken || (_closeSent && _queue.empty());
+    }
+
+    void WebSocketConnection::HandleFrame(const WebSocketFrameHeader& header, char* payload, size_t length) {
+        if (header.reserved) {
+            Fail(1002);
+            return;
+        }
+
+        bool control = static_cast<std::uint8_t>(header.opcode) >= 0x8;
+        if (control && (!header.fin || length > MAX_CONTROL_PAYLOAD)) {
+            Fail(1002);
+            return;
+        }
+
+        switch (header.opcode) {
+            case WebSocketOpcode::Text:
+            case WebSocketOpcode::Binary:
+                if (_inMessage) {
+                    Fail(1002);
+                    return;
+                }
+                if (!header.fin) {
+                    _inMessage = true;
+                    _messageOpcode = header.opcode;
+                    _message.assign(payload, length);
+                    return;
+                }
+                if (header.opcode == WebSocketOpcode::Text && !IsValidUtf8(payload, length)) {
+                    Fail(1007);
+                    return;
+                }
+                Deliver(header.opcode, StringView(payload, length));
+                return;
+
+            case WebSocketOpcode::Continuation:
+                if (!_inMessage) {
+                    Fail(1002);
+                    return;
+                }
+                if (_message.size() + length > config::WEBSOCKET_MAX_MESSAGE_SIZE) {
+                    Fail(1009);
+                    return;
+                }
+                _message.append(payload, length);
+                if (!header.fin) return;
+
+                _inMessage = false;
+                if (_messageOpcode == WebSocketOpcode::Text && !IsValidUtf8(_message.data(), _message.size())) {
+                    Fail(1007);
+                    return;
+                }
+                Deliver(_messageOpcode, StringView(_message.data(), _message.size()));
+                _message.clear();
+                return;
+
+            case WebSocketOpcode::Ping:
+                Send(MakeWebSocketFrame(WebSocketOpcode::Pong, StringView(payload, length)));
+                return;
+
+            case WebSocketOpcode::Pong:
+                return;
+
+            case WebSocketOpcode::Close: {
+                if (length == 1) {
+                    Fail(1002);
+                    return;
+                }
+                if (length == 0) {
+                    _closeCode = 1005;
+                    SendClose(StringView());
+                    return;
+                }
+
+                std::uint16_t code = static_cast<std::uint16_t>(
+                    (static_cast<unsigned char>(payload[0]) << 8) | static_cast<unsigned char>(payload[1]));
+                if (!IsValidCloseCode(code)) {
+                    Fail(1002);
+                    return;
+                }
+                if (!IsValidUtf8(payload + 2, length - 2)) {
+                    Fail(1007);
+                    return;
+                }
+                // Echo the status code back
+                _closeCode = code;
+                SendClose(StringView(payload, 2));
+                return;
+            }
+
+            default:
+                Fail(1002);
+                return;
+        }
+    }
+
+    void WebSocketConnection::Deliver(WebSocketOpcode opcode, StringView payload) {
+        if (_handler->onMessage) {
+            _handler->onMessage(*this, opcode, payload);
+        }
+    }
+
+    void WebSocketConnection::Fail(std::uint16_t code) {
+        _inMessage = false;
+        _message.clear();
+        Close(code);
+    }
+
+    void WebSocketConnection::SendClose(StringView payload) {
+        if (_closeSent || _broken) return;
+        Enqueue(MakeWebSocketFrame(WebSocketOpcode::Close, payload));
+        _closeSent = true;
+    }
+
+    void WebSocketConnection::Enqueue(const WebSocketFrame& frame) {
+        // Drop clients that stop reading instead of buffering without bound
+        if (_queuedBytes + frame->size() > config::WEBSOCKET_MAX_QUEUED_BYTES) {
+            _broken = true;
+            return;
+        }
+
+        _queue.push_back(PendingFrame{frame, 0});
+        _queuedBytes += frame->size();
+        if (_wantWrite) return;
+
+        Flush();
+        if (!_queue.empty() && !_broken) {
+            UpdateInterest(true);
+        }
+    }
+
+    void WebSocketConnection::Flush() {
+        // Userspace TLS encrypts one frame at a time, a kernel TLS socket takes the gathered frames as they are
+        if (_tls != nullptr && !_tls->IsKernelSend()) {
+            FlushTls();
+            return;
+        }
+
+        while (!_queue.empty()) {
+            iovec vectors[config::WEBSOCKET_MAX_IOVECS];
+            int count = 0;
+            for (auto it = _queue.begin(); it != _queue.end() && count < config::WEBSOCKET_MAX_IOVECS; ++it) {
+                vectors[count].iov_base = const_cast<char*>(it->frame->data()) + it->offset;
+                vectors[count].iov_len = it->frame->size() - it->offset;
+                ++count;
+            }
+
+            msghdr message = {};
+            message.msg_iov = vectors;
+            message.msg_iovlen = count;
+            ssize_t byteCount = sendmsg(_fd, &message, MSG_NOSIGNAL);
+            if (byteCount < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) _broken = true;
+                return;
+            }
+
+            size_t sent = static_cast<size_t>(byteCount);
+            _queuedBytes -= sent;
+            while (sent > 0) {
+                PendingFrame& front = _queue.front();
+                size_t remaining = front.frame->size() - front.offset;
+                if (sent < remaining) {
+                    front.offset += sent;
+                    break;
+                }
+                sent -= remaining;
+                _queue.pop_front();
+            }
+        }
+    }
+
+    void WebSocketConnection::FlushTls() {
+        while (!_queue.empty()) {
+            PendingFrame& front = _queue.front();
+            size_t remaining = front.frame->size() - front.offset;
+            ssize_t byteCount = _tls->Write(front.frame->data() + front.offset, remaining);
+            if (byteCount < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) _broken = true;
+                return;
+            }
+
+            size_t sent = static_cast<size_t>(byteCount);
+            _queuedBytes -= sent;
+            if (sent < remaining) {
+                front.offset += sent;
+            } else {
+                _queue.pop_front();
+            }
+        }
+    }
+
+    void WebSocketConnection::UpdateInterest(bool wantWrite) {
+        epoll_event event;
+        event.events = wantWrite ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        event.data.ptr = _eventData;
+        if (epoll_ctl(_epollFd, EPOLL_CTL_MOD, _fd, &event) == -1) {
+            _broken = true;
+            return;
+        }
+        _wantWrite = wantWrite;
+    }
+}
\ No newline at end of file
@@ -2,9 +2,11 @@
 #include <sys/resource.h>
 #include <sys/time.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cerrno>
 #include <chrono>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <stdexcept>
@@ -15,11 +17,25 @@
 #include "../include/http/http_message.h"
 #include "../include/http/uri.h"
 
+using httpserver::AccessLogFormat;
 using httpserver::HttpMethod;
 using httpserver::HttpRequest;
 using httpserver::HttpResponse;
 using httpserver::HttpServer;
 using httpserver::HttpStatusCode;
+using httpserver::ListenerConfig;
+using httpserver::LoadBalancerConfig;
+using httpserver::PlacementPolicy;
+using httpserver::RateLimitConfig;
+using httpserver::RateLimitMode;
+using httpserver::StringView;
+using httpserver::TlsConfig;
+using httpserver::TlsContext;
+using httpserver::TlsStats;
+using httpserver::WebSocketConnection;
+using httpserver::WebSocketHandler;
+using httpserver::WebSocketOpcode;
+using httpserver::WorkerLoadStats;
 
 // Handle Ctrl+C and kill signals
 std::atomic<bool> gRunning{true};
@@ -30,12 +46,65 @@ void terminateHandler(int signal) {
     }
 }
 
+// SIGHUP asks the access log to reopen its file, e.g. after logrotate
+std::atomic<bool> gReopenLog{false};
+void reopenHandler(int signal) {
+    if (signal == SIGHUP) {
+        gReopenLog = true;
+    }
+}
+
 int main() {
     signal(SIGINT, terminateHandler);
     signal(SIGTERM, terminateHandler);
+    signal(SIGHUP, reopenHandler);
     
     HttpServer server("0.0.0.0", 8080);
 
+    // Optional Unix domain socket next to the TCP port, a leading '@' selects the abstract namespace
+    if (const char* unixSocket = std::getenv("HTTP_SERVER_UNIX_SOCKET")) {
+        server.AddListener(ListenerConfig::Unix(unixSocket));
+    }
+
+    // HTTPS on port 8443 when a certificate and key are given
+    const char* tlsCertificate = std::getenv("HTTP_SERVER_TLS_CERT");
+    const char* tlsKey = std::getenv("HTTP_SERVER_TLS_KEY");
+    if (tlsCertificate && tlsKey) {
+        server.AddListener(ListenerConfig::Https("0.0.0.0", 8443, TlsConfig(tlsCertificate, tlsKey)));
+    }
+
+    // Access logging is off unless a log file is given
+    if (const char* accessLogPath = std::getenv("HTTP_SERVER_ACCESS_LOG")) {
+        const char* formatName = std::getenv("HTTP_SERVER_ACCESS_LOG_FORMAT");
+        AccessLogFormat format = AccessLogFormat::Combined;
+        if (formatName && std::strcmp(formatName, "common") == 0) format = AccessLogFormat::Common;
+        if (formatName && std::strcmp(formatName, "json") == 0) format = AccessLogFormat::JsonLines;
+        server.EnableAccessLog(accessLogPath, format);
+    }
+
+    // Per-client rate limit in requests per second, burst defaults to one second worth of requests
+    // and at least one request, so rates below 1/s still admit a request now and then
+    if (const char* rate = std::getenv("HTTP_SERVER_RATE_LIMIT")) {
+        double requestsPerSecond = std::atof(rate);
+        RateLimitConfig limit(requestsPerSecond, std::max(1.0, requestsPerSecond));
+        const char* mode = std::getenv("HTTP_SERVER_RATE_LIMIT_MODE");
+        if (mode && std::strcmp(mode, "accept") == 0) limit.mode = RateLimitMode::Accept;
+        server.EnableRateLimit(limit);
+    }
+
+    // Connection placement: round-robin (default), least-connections or p2c, optionally rebalanced
+    const char* placement = std::getenv("HTTP_SERVER_PLACEMENT");
+    LoadBalancerConfig balancing;
+    if (placement && std::strcmp(placement, "least-connections") == 0) balancing.policy = PlacementPolicy::LeastConnections;
+    if (placement && std::strcmp(placement, "p2c") == 0) balancing.policy = PlacementPolicy::PowerOfTwoChoices;
+    balancing.rebalance = std::getenv("HTTP_SERVER_REBALANCE") != nullptr;
+    server.SetLoadBalancing(balancing);
+
+    // Fraction of requests traced, reports are served on /debug/trace
+    if (const char* traceRate = std::getenv("HTTP_SERVER_TRACE_SAMPLE_RATE")) {
+        server.EnableRequestTracing(std::atof(traceRate));
+    }
+
     auto test = [](const HttpRequest& request) -> HttpResponse {
         HttpResponse response(HttpStatusCode::OK);
         response.SetHeader("Content-Type", "text/plain");
@@ -46,13 +115,78 @@ int main() {
     server.RegisterRequestHandler("/", HttpMethod::HEAD, test);
     server.RegisterRequestHandler("/", HttpMethod::GET, test);
 
+    // Per-worker load, one line per worker
+    server.RegisterRequestHandler("/debug/workers", HttpMethod::GET, [&server](const HttpRequest&) {
+        std::string body = "imbalance " + std::to_string(server.GetLoadImbalance()) + "\n";
+        for (int i = 0; i < httpserver::config::WORKER_POOL_SIZE; ++i) {
+            WorkerLoadStats stats = server.GetWorkerLoad(i);
+            body += "worker " + std::to_string(i) + " connections " + std::to_string(stats.connections) +
+                    " events " + std::to_string(stats.events) + " load " + std::to_string(stats.load) +
+                    " migrated_in " + std::to_string(stats.migratedIn) +
+                    " migrated_out " + std::to_string(stats.migratedOut) + "\n";
+        }
+        HttpResponse response(HttpStatusCode::OK);
+        response.SetHeader("Content-Type", "text/plain");
+        response.SetContent(body);
+        return response;
+    });
+
+    // TLS handshake counters of every HTTPS listener
+    server.RegisterRequestHandler("/debug/tls", HttpMethod::GET, [&server](const HttpRequest&) {
+        std::string body;
+        for (const auto& listener : server.GetListeners()) {
+            if (TlsContext* tls = listener->GetTls()) {
+                TlsStats stats = tls->GetStats();
+                body += listener->Describe() + " handshakes " + std::to_string(stats.handshakes) +
+                        " resumed " + std::to_string(stats.resumed) + " failed " + std::to_string(stats.failed) +
+                        " ktls_tx " + std::to_string(stats.kernelSend) +
+                        " ktls_rx " + std::to_string(stats.kernelReceive) + "\n";
+            }
+        }
+        HttpResponse response(HttpStatusCode::OK);
+        response.SetHeader("Content-Type", "text/plain");
+        response.SetContent(body);
+        return response;
+    });
+
+    // WebSocket echo, and a chat room that relays every message to all of its members
+    WebSocketHandler echo;
+    echo.onMessage = [](WebSocketConnection& connection, WebSocketOpcode opcode, StringView message) {
+        if (opcode == WebSocketOpcode::Text) connection.SendText(message);
+        else connection.SendBinary(message);
+    };
+    server.RegisterWebSocketHandler("/echo", echo);
+
+    WebSocketHandler chat;
+    chat.onMessage = [&server](WebSocketConnection& connection, WebSocketOpcode opcode, StringView message) {
+        server.BroadcastWebSocket(connection.GetPath(), opcode, message);
+    };
+    server.RegisterWebSocketHandler("/chat", chat);
+
+    // Prefork mode runs this many single-loop worker processes, their counters are served on port 8081
+    int processes = 0;
+    if (const char* prefork = std::getenv("HTTP_SERVER_PREFORK")) {
+        processes = std::atoi(prefork);
+        server.SetProcessStatsListener(ListenerConfig::Tcp("127.0.0.1", 8081));
+    }
+
     try {
-        server.Start();
-        std::cout << "Server listening on 0.0.0.0:8080" << std::endl;
+        if (processes > 0) {
+            server.StartPrefork(processes);
+            std::cout << "Started " << processes << " worker processes, stats on 127.0.0.1:8081" << std::endl;
+        } else {
+            server.Start();
+        }
+        for (const auto& listener : server.GetListeners()) {
+            std::cout << "Server listening on " << listener->Describe() << std::endl;
+        }
         std::cout << "Press Ctrl+C to stop the server" << std::endl;
         
         while (gRunning) {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            if (gReopenLog.exchange(false)) {
+                server.ReopenAccessLog();
+            }
         }
         
         server.Stop();
@@ -0,0 +1,99 @@
+#include <cstdlib>
+#include <new>
+
+#include "../../include/utils/arena.h"
+
+namespace httpserver {
+
+    namespace {
+        thread_local Arena* tCurrentArena = nullptr;
+    }
+
+    Arena::Arena(size_t blockSize) :
+        _blocks(nullptr),
+        _cursor(nullptr),
+        _end(nullptr),
+        _blockSize(blockSize),
+        _bytesUsed(0),
+        _capacity(0) {}
+
+    Arena::~Arena() {
+        FreeBlocks();
+    }
+
+    void* Arena::Allocate(size_t size, size_t alignment) {
+        std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(_cursor) + alignment - 1) & ~(alignment - 1);
+        if (_cursor == nullptr || aligned + size > reinterpret_cast<std::uintptr_t>(_end)) {
+            AddBlock(size + alignment);
+            aligned = (reinterpret_cast<std::uintptr_t>(_cursor) + alignment - 1) & ~(alignment - 1);
+        }
+        _cursor = reinterpret_cast<char*>(aligned + size);
+        _bytesUsed += size;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    void Arena::Reset() {
+        if (_blocks == nullptr) {
+            return;
+        }
+        // One allocation larger than the cap leaves a single block that would otherwise be kept forever
+        bool oversized = _capacity > config::ARENA_MAX_BLOCK_SIZE && _capacity > _blockSize;
+        if (_blocks->next != nullptr || oversized) {
+            // Replace the blocks with one block big enough for next time, capped in size
+            size_t grown = _capacity < config::ARENA_MAX_BLOCK_SIZE ? _capacity : config::ARENA_MAX_BLOCK_SIZE;
+            if (grown > _blockSize) {
+                _blockSize = grown;
+            }
+            FreeBlocks();
+            AddBlock(_blockSize);
+        }
+        _cursor = reinterpret_cast<char*>(_blocks + 1);
+        _bytesUsed = 0;
+    }
+
+    size_t Arena::GetBytesUsed() const {
+        return _bytesUsed;
+    }
+
+    size_t Arena::GetCapacity() const {
+        return _capacity;
+    }
+
+    Arena* Arena::Current() {
+        return tCurrentArena;
+    }
+
+    void Arena::AddBlock(size_t minimumSize) {
+        size_t size = minimumSize > _blockSize ? minimumSize : _blockSize;
+        Block* block = static_cast<Block*>(std::malloc(sizeof(Block) + size));
+        if (block == nullptr) {
+            throw std::bad_alloc();
+        }
+        block->next = _blocks;
+        block->size = size;
+        _blocks = block;
+        _cursor = reinterpret_cast<char*>(block + 1);
+        _end = _cursor + size;
+        _capacity += size;
+    }
+
+    void Arena::FreeBlocks() {
+        while (_blocks != nullptr) {
+            Block* next = _blocks->next;
+            std::free(_blocks);
+            _blocks = next;
+        }
+        _cursor = nullptr;
+        _end = nullptr;
+        _capacity = 0;
+    }
+
+    Arena::Scope::Scope(Arena& arena) : _previous(tCurrentArena) {
+        tCurrentArena = &arena;
+    }
+
+    Arena::Scope::~Scope() {
+        tCurrentArena = _previous;
+    }
+
+}
@@ -0,0 +1,32 @@
+#include <cstdint>
+
+#include "../../include/utils/base64.h"
+
+namespace httpserver {
+
+    std::string Base64Encode(const void* data, size_t length) {
+        static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+        std::string encoded;
+        encoded.reserve((length + 2) / 3 * 4);
+
+        size_t i = 0;
+        for (; i + 3 <= length; i += 3) {
+            std::uint32_t group = (std::uint32_t(bytes[i]) << 16) | (std::uint32_t(bytes[i + 1]) << 8) | bytes[i + 2];
+            encoded += kAlphabet[(group >> 18) & 63];
+            encoded += kAlphabet[(group >> 12) & 63];
+            encoded += kAlphabet[(group >> 6) & 63];
+            encoded += kAlphabet[group & 63];
+        }
+        if (i < length) {
+            std::uint32_t group = std::uint32_t(bytes[i]) << 16;
+            if (i + 1 < length) group |= std::uint32_t(bytes[i + 1]) << 8;
+            encoded += kAlphabet[(group >> 18) & 63];
+            encoded += kAlphabet[(group >> 12) & 63];
+            encoded += i + 1 < length ? kAlphabet[(group >> 6) & 63] : '=';
+            encoded += '=';
+        }
+        return encoded;
+    }
+
+}
@@ -0,0 +1,257 @@
+#include <cstdint>
+
+#include "../../include/utils/scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HTTPSERVER_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace httpserver {
+    namespace scan {
+
+        namespace {
+            bool IsTokenChar(unsigned char c) {
+                if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+                    return true;
+                }
+                switch (c) {
+                    case '!': case '#': case '$': case '%': case '&': case '\'': case '*':
+                    case '+': case '-': case '.': case '^': case '_': case '`': case '|': case '~':
+                        return true;
+                    default:
+                        return false;
+                }
+            }
+
+            bool IsFieldValueChar(unsigned char c) {
+                return (c >= 0x20 && c != 0x7F) || c == '\t';
+            }
+
+            // Lookup tables shared by all kernels, built once at startup
+            struct Tables {
+                bool token[256];
+                // Vector token test: byte b is a tchar when tokenLow[b & 15] has bit (b >> 4) set.
+                // Rows are duplicated so AVX2 can shuffle both 128-bit lanes.
+                alignas(32) std::uint8_t tokenLow[32];
+                alignas(32) std::uint8_t highBit[32];
+
+                Tables() : token(), tokenLow(), highBit() {
+                    for (int c = 0; c < 256; ++c) {
+                        token[c] = IsTokenChar(static_cast<unsigned char>(c));
+                        if (token[c]) {
+                            tokenLow[c & 15] |= static_cast<std::uint8_t>(1 << (c >> 4));
+                            tokenLow[16 + (c & 15)] = tokenLow[c & 15];
+                        }
+                    }
+                    for (int h = 0; h < 8; ++h) {
+                        highBit[h] = highBit[16 + h] = static_cast<std::uint8_t>(1 << h);
+                    }
+                }
+            };
+            const Tables kTables;
+
+            const char* ScalarFindChar(const char* begin, const char* end, char c) {
+                while (begin < end && *begin != c) ++begin;
+                return begin;
+            }
+
+            const char* ScalarFindCRLF(const char* begin, const char* end) {
+                for (; begin + 1 < end; ++begin) {
+                    if (begin[0] == '\r' && begin[1] == '\n') return begin;
+                }
+                return end;
+            }
+
+            const char* ScalarFindNonToken(const char* begin, const char* end) {
+                while (begin < end && kTables.token[static_cast<unsigned char>(*begin)]) ++begin;
+                return begin;
+            }
+
+            const char* ScalarFindNonFieldValue(const char* begin, const char* end) {
+                while (begin < end && IsFieldValueChar(static_cast<unsigned char>(*begin))) ++begin;
+                return begin;
+            }
+
+            const Kernels kScalarKernels = {
+                ScalarFindChar, ScalarFindCRLF, ScalarFindNonToken, ScalarFindNonFieldValue
+            };
+
+#ifdef HTTPSERVER_SCAN_X86
+            // SSE4.2 tier, 16 bytes per step
+
+            __attribute__((target("sse4.2")))
+            const char* Sse42FindChar(const char* begin, const char* end, char c) {
+                const __m128i needle = _mm_set1_epi8(c);
+                for (; end - begin >= 16; begin += 16) {
+                    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+                    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+                    if (mask) return begin + __builtin_ctz(mask);
+                }
+                return ScalarFindChar(begin, end, c);
+            }
+
+            __attribute__((target("sse4.2")))
+            const char* Sse42FindCRLF(const char* begin, const char* end) {
+                const __m128i cr = _mm_set1_epi8('\r');
+                const __m128i lf = _mm_set1_epi8('\n');
+                for (; end - begin >= 17; begin += 16) {
+                    __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+                    __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + 1));
+                    int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, cr), _mm_cmpeq_epi8(second, lf)));
+                    if (mask) return begin + __builtin_ctz(mask);
+                }
+                return ScalarFindCRLF(begin, end);
+            }
+
+            __attribute__((target("sse4.2")))
+            const char* Sse42FindNonToken(const char* begin, const char* end) {
+                const __m128i lowTable = _mm_load_si128(reinterpret_cast<const __m128i*>(kTables.tokenLow));
+                const __m128i highTable = _mm_load_si128(reinterpret_cast<const __m128i*>(kTables.highBit));
+                const __m128i nibble = _mm_set1_epi8(0x0F);
+                for (; end - begin >= 16; begin += 16) {
+                    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+                    __m128i low = _mm_shuffle_epi8(lowTable, _mm_and_si128(chunk, nibble));
+                    __m128i high = _mm_shuffle_epi8(highTable, _mm_and_si128(_mm_srli_epi16(chunk, 4), nibble));
+                    __m128i invalid = _mm_cmpeq_epi8(_mm_and_si128(low, high), _mm_setzero_si128());
+                    int mask = _mm_movemask_epi8(invalid);
+                    if (mask) return begin + __builtin_ctz(mask);
+                }
+                return ScalarFindNonToken(begin, end);
+            }
+
+            __attribute__((target("sse4.2")))
+            const char* Sse42FindNonFieldValue(const char* begin, const char* end) {
+                const __m128i control = _mm_set1_epi8(0x1F);
+                const __m128i tab = _mm_set1_epi8('\t');
+                const __m128i del = _mm_set1_epi8(0x7F);
+                for (; end - begin >= 16; begin += 16) {
+                    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+                    __m128i isControl = _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control);
+                    __m128i invalid = _mm_or_si128(_mm_andnot_si128(_mm_cmpeq_epi8(chunk, tab), isControl),
+                                                   _mm_cmpeq_epi8(chunk, del));
+                    int mask = _mm_movemask_epi8(invalid);
+                    if (mask) return begin + __builtin_ctz(mask);
+                }
+                return ScalarFindNonFieldValue(begin, end);
+            }
+
+            const Kernels kSse42Kernels = {
+                Sse42FindChar, Sse42FindCRLF, Sse42FindNonToken, Sse42FindNonFieldValue
+            };
+
+            // AVX2 tier, 32 bytes per step, tails go through the SSE4.2 kernels.
+            // GCC does not clear the upper lanes before the tail call, so do it explicitly to avoid
+            // the AVX to SSE transition penalty.
+
+            __attribute__((target("avx2")))
+            const char* Avx2FindChar(const char* begin, const char* end, char c) {
+                const __m256i needle = _mm256_set1_epi8(c);
+                for (; end - begin >= 32; begin += 32) {
+                    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+                    std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+                    if (mask) return begin + __builtin_ctz(mask);
+                }
+                _mm256_zeroupper();
+                return Sse42FindChar(begin, end, c);
+            }
+
+            __attribute__((target("avx2")))
+            const char* Avx2FindCRLF(const char* begin, const char* end) {
+                const __m256i cr = _mm256_set1_epi8('\r');
+                const __m256i lf = _mm256_set1_epi8('\n');
+                for (; end - begin >= 33; begin += 32) {
+                    __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+                    __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin + 1));
+                    std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(
+                        _mm256_and_si256(_mm256_cmpeq_epi8(first, cr), _mm256_cmpeq_epi8(second, lf))));
+                    if (mask) return begin + __builtin_ctz(mask);
+                }
+                _mm256_zeroupper();
+                return Sse42FindCRLF(begin, end);
+            }
+
+            __attribute__((target("avx2")))
+            const char* Avx2FindNonToken(const char* begin, const char* end) {
+                const __m256i lowTable = _mm256_load_si256(reinterpret_cast<const __m256i*>(kTables.tokenLow));
+                const __m256i highTable = _mm256_load_si256(reinterpret_cast<const __m256i*>(kTables.highBit));
+                const __m256i nibble = _mm256_set1_epi8(0x0F);
+                for (; end - begin >= 32; begin += 32) {
+                    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+                    __m256i low = _mm256_shuffle_epi8(lowTable, _mm256_and_si256(chunk, nibble));
+                    __m256i high = _mm256_shuffle_epi8(highTable, _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibble));
+                    __m256i invalid = _mm256_cmpeq_epi8(_mm256_and_si256(low, high), _mm256_setzero_si256());
+                    std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(invalid));
+                    if (mask) return begin + __builtin_ctz(mask);
+                }
+                _mm256_zeroupper();
+                return Sse42FindNonToken(begin, end);
+            }
+
+            __attribute__((target("avx2")))
+            const char* Avx2FindNonFieldValue(const char* begin, const char* end) {
+                const __m256i control = _mm256_set1_epi8(0x1F);
+                const __m256i tab = _mm256_set1_epi8('\t');
+                const __m256i del = _mm256_set1_epi8(0x7F);
+                for (; end - begin >= 32; begin += 32) {
+                    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+                    __m256i isControl = _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control), control);
+                    __m256i invalid = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi8(chunk, tab), isControl),
+                                                      _mm256_cmpeq_epi8(chunk, del));
+                    std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(invalid));
+                    if (mask) return begin + __builtin_ctz(mask);
+                }
+                _mm256_zeroupper();
+                return Sse42FindNonFieldValue(begin, end);
+            }
+
+            const Kernels kAvx2Kernels = {
+                Avx2FindChar, Avx2FindCRLF, Avx2FindNonToken, Avx2FindNonFieldValue
+            };
+#endif
+
+            const Kernels*& ActivePointer() {
+                static const Kernels* active = &GetKernels(DetectIsa());
+                return active;
+            }
+        }
+
+        Isa DetectIsa() {
+#ifdef HTTPSERVER_SCAN_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) return Isa::AVX2;
+            if (__builtin_cpu_supports("sse4.2")) return Isa::SSE42;
+#endif
+            return Isa::Scalar;
+        }
+
+        const char* GetIsaName(Isa isa) {
+            switch (isa) {
+                case Isa::Scalar: return "scalar";
+                case Isa::SSE42: return "sse4.2";
+                case Isa::AVX2: return "avx2";
+                default: return "unknown";
+            }
+        }
+
+        const Kernels& GetKernels(Isa isa) {
+#ifdef HTTPSERVER_SCAN_X86
+            Isa supported = DetectIsa();
+            if (isa == Isa::AVX2 && supported == Isa::AVX2) return kAvx2Kernels;
+            if (isa == Isa::SSE42 && supported != Isa::Scalar) return kSse42Kernels;
+#else
+            (void)isa;
+#endif
+            return kScalarKernels;
+        }
+
+        const Kernels& ActiveKernels() {
+            return *ActivePointer();
+        }
+
+        void SelectIsa(Isa isa) {
+            ActivePointer() = &GetKernels(isa);
+        }
+
+    }
+}
@@ -1,13 +1,60 @@
 #include <string>
 #include <sstream>
 #include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <stdexcept>
+#include "../../include/utils/scan.h"
 #include "../../include/utils/serialize.h"
 #include "../../include/http/http_message.h"
 #include "../../include/http/uri.h"
+#include "../../include/http/uri_view.h"
 
 using namespace httpserver;
 
+namespace {
+    // Static texts shared by ToString and ToBuffer, the latter must not allocate
+    const char* VersionText(HttpVersion version) {
+        switch (version) {
+            case HttpVersion::HTTP_10: return "HTTP/1.0";
+            case HttpVersion::HTTP_11: return "HTTP/1.1";
+            case HttpVersion::HTTP_20: return "HTTP/2.0";
+            default: return "UNKNOWN";
+        }
+    }
+
+    const char* StatusText(HttpStatusCode status_code) {
+        switch (status_code) {
+            case HttpStatusCode::SwitchingProtocols: return "101 Switching Protocols";
+            case HttpStatusCode::OK: return "200 OK";
+            case HttpStatusCode::Created: return "201 Created";
+            case HttpStatusCode::NoContent: return "204 No Content";
+            case HttpStatusCode::BadRequest: return "400 Bad Request";
+            case HttpStatusCode::Unauthorized: return "401 Unauthorized";
+            case HttpStatusCode::Forbidden: return "403 Forbidden";
+            case HttpStatusCode::NotFound: return "404 Not Found";
+            case HttpStatusCode::MethodNotAllowed: return "405 Method Not Allowed";
+            case HttpStatusCode::UpgradeRequired: return "426 Upgrade Required";
+            case HttpStatusCode::TooManyRequests: return "429 Too Many Requests";
+            case HttpStatusCode::InternalServerError: return "500 Internal Server Error";
+            case HttpStatusCode::NotImplemented: return "501 Not Implemented";
+            case HttpStatusCode::BadGateway: return "502 Bad Gateway";
+            case HttpStatusCode::ServiceUnavailable: return "503 Service Unavailable";
+            case HttpStatusCode::GatewayTimeout: return "504 Gateway Timeout";
+            case HttpStatusCode::HttpVersionNotSupported: return "505 HTTP Version Not Supported";
+            default: return "UNKNOWN";
+        }
+    }
+
+    // Copies as much of data as fits and advances the cursor
+    void Write(char*& cursor, char* end, const char* data, size_t length) {
+        size_t available = static_cast<size_t>(end - cursor);
+        if (length > available) length = available;
+        std::memcpy(cursor, data, length);
+        cursor += length;
+    }
+}
+
 template <>
 std::string ToString<HttpMethod>(HttpMethod method) {
     switch (method) {
@@ -26,33 +73,12 @@ std::string ToString<HttpMethod>(HttpMethod method) {
 
 template <>
 std::string ToString<HttpVersion>(HttpVersion version) {
-    switch (version) {
-        case HttpVersion::HTTP_10: return "HTTP/1.0";
-        case HttpVersion::HTTP_11: return "HTTP/1.1";
-        case HttpVersion::HTTP_20: return "HTTP/2.0";
-        default: return "UNKNOWN";
-    }
+    return VersionText(version);
 }
 
 template <>
 std::string ToString<HttpStatusCode>(HttpStatusCode status_code) {
-    switch (status_code) {
-        case HttpStatusCode::OK: return "200 OK";
-        case HttpStatusCode::Created: return "201 Created";
-        case HttpStatusCode::NoContent: return "204 No Content";
-        case HttpStatusCode::BadRequest: return "400 Bad Request";
-        case HttpStatusCode::Unauthorized: return "401 Unauthorized";
-        case HttpStatusCode::Forbidden: return "403 Forbidden";
-        case HttpStatusCode::NotFound: return "404 Not Found";
-        case HttpStatusCode::MethodNotAllowed: return "405 Method Not Allowed";
-        case HttpStatusCode::InternalServerError: return "500 Internal Server Error";
-        case HttpStatusCode::NotImplemented: return "501 Not Implemented";
-        case HttpStatusCode::BadGateway: return "502 Bad Gateway";
-        case HttpStatusCode::ServiceUnavailable: return "503 Service Unavailable";
-        case HttpStatusCode::GatewayTimeout: return "504 Gateway Timeout";
-        case HttpStatusCode::HttpVersionNotSupported: return "505 HTTP Version Not Supported";
-        default: return "UNKNOWN";
-    }
+    return StatusText(status_code);
 }
 
 template <>
@@ -72,11 +98,12 @@ std::string ToString<HttpRequest>(HttpRequest request) {
     oss << ToString(request.GetURI()) << ' ';
     oss << ToString(request.GetVersion()) << "\r\n";
     
-    for (const auto& header : request.GetHeaders()) {
-        oss << header.first << ": " << header.second << "\r\n";
-    }
+    request.ForEachHeader([&oss](StringView name, StringView value) {
+        oss.write(name.Data(), name.Length()) << ": ";
+        oss.write(value.Data(), value.Length()) << "\r\n";
+    });
     oss << "\r\n";
-    oss << request.GetContent();
+    oss.write(request.GetContentView().Data(), request.GetContentView().Length());
     return oss.str();
 }
 
@@ -85,14 +112,38 @@ std::string ToString<HttpResponse>(HttpResponse response) {
     std::ostringstream oss;
     oss << ToString(response.GetVersion()) << " " << ToString(response.GetStatusCode()) << "\r\n";
     
-    for (const auto& header : response.GetHeaders()) {
-        oss << header.first << ": " << header.second << "\r\n";
-    }
+    response.ForEachHeader([&oss](StringView name, StringView value) {
+        oss.write(name.Data(), name.Length()) << ": ";
+        oss.write(value.Data(), value.Length()) << "\r\n";
+    });
     oss << "\r\n";
-    oss << response.GetContent();
+    oss.write(response.GetContentView().Data(), response.GetContentView().Length());
     return oss.str();
 }
 
+template <>
+size_t ToBuffer<HttpResponse>(const HttpResponse& response, char* buffer, size_t size) {
+    char* cursor = buffer;
+    char* end = buffer + size;
+    const char* version = VersionText(response.GetVersion());
+    const char* status = StatusText(response.GetStatusCode());
+
+    Write(cursor, end, version, std::strlen(version));
+    Write(cursor, end, " ", 1);
+    Write(cursor, end, status, std::strlen(status));
+    Write(cursor, end, "\r\n", 2);
+    response.ForEachHeader([&cursor, end](StringView name, StringView value) {
+        Write(cursor, end, name.Data(), name.Length());
+        Write(cursor, end, ": ", 2);
+        Write(cursor, end, value.Data(), value.Length());
+        Write(cursor, end, "\r\n", 2);
+    });
+    Write(cursor, end, "\r\n", 2);
+    StringView content = response.GetContentView();
+    Write(cursor, end, content.Data(), content.Length());
+    return static_cast<size_t>(cursor - buffer);
+}
+
 template <>
 HttpMethod FromString<HttpMethod>(const std::string& method_string) {
     if (method_string == "GET") return HttpMethod::GET;
@@ -116,60 +167,78 @@ HttpVersion FromString<HttpVersion>(const std::string& version_string) {
 }
 
 template <>
-HttpRequest FromString<HttpRequest>(const std::string& requestString) {
+HttpRequest FromString<HttpRequest>(const char* data, size_t length) {
     HttpRequest request;
+    const char* begin = data;
+    const char* end = data + length;
 
-    size_t startLineEnd = requestString.find("\r\n");
-    if (startLineEnd == std::string::npos) {
+    const char* startLineEnd = scan::FindCRLF(begin, end);
+    if (startLineEnd == end) {
         throw std::invalid_argument("Invalid HTTP request: missing start line");
     }
-    std::string startLine = requestString.substr(0, startLineEnd);
 
-    std::string method, path, version;
-    std::istringstream startStream(startLine);
-    if (!(startStream >> method >> path >> version)) {
-        throw std::invalid_argument("Invalid start line format");
+    // Tokenize in place so the URI view can reference the request buffer
+    const char* tokenStart[3];
+    const char* tokenEnd[3];
+    const char* pos = begin;
+    for (int i = 0; i < 3; ++i) {
+        while (pos < startLineEnd && std::isspace(static_cast<unsigned char>(*pos))) ++pos;
+        tokenStart[i] = pos;
+        while (pos < startLineEnd && !std::isspace(static_cast<unsigned char>(*pos))) ++pos;
+        tokenEnd[i] = pos;
+        if (tokenStart[i] == tokenEnd[i]) {
+            throw std::invalid_argument("Invalid start line format");
+        }
     }
 
-    request.SetMethod(FromString<HttpMethod>(method));
-    request.SetURI(URI(path));
+    request.SetMethod(FromString<HttpMethod>(std::string(tokenStart[0], tokenEnd[0])));
+    request.SetURIView(URIView(tokenStart[1], tokenEnd[1] - tokenStart[1]));
 
-    if (FromString<HttpVersion>(version) != request.GetVersion()) {
+    if (FromString<HttpVersion>(std::string(tokenStart[2], tokenEnd[2])) != request.GetVersion()) {
         throw std::logic_error("Unsupported HTTP version");
     }
 
-    size_t headersEnd = requestString.find("\r\n\r\n", startLineEnd + 2);
-    std::string headerLines, messageBody;
-
-    if (headersEnd != std::string::npos) {
-        headerLines = requestString.substr(startLineEnd + 2, headersEnd - (startLineEnd + 2));
-        messageBody = requestString.substr(headersEnd + 4);
-    }
-
-    std::istringstream headersStream(headerLines);
-    std::string headerLine;
-
-    while (std::getline(headersStream, headerLine)) {
-        if (headerLine.empty()) continue;
-        
-        if (headerLine.back() == '\r') {
-            headerLine.pop_back();
+    // Single pass over the header block, an empty line terminates it
+    const char* lineStart = startLineEnd + 2;
+    bool headersComplete = false;
+
+    while (lineStart < end) {
+        const char* lineEnd = scan::FindCRLF(lineStart, end);
+        if (lineEnd == end) break;
+        if (lineEnd == lineStart) {
+            lineStart += 2;
+            headersComplete = true;
+            break;
         }
 
-        size_t colonPos = headerLine.find(':');
-        if (colonPos == std::string::npos) continue;
-
-        std::string headerKey = headerLine.substr(0, colonPos);
-        std::string headerValue = headerLine.substr(colonPos + 1);
-
-        headerKey.erase(std::remove_if(headerKey.begin(), headerKey.end(), ::isspace), headerKey.end());
-        headerValue.erase(std::remove_if(headerValue.begin(), headerValue.end(), ::isspace), headerValue.end());
-
-        if (!headerKey.empty()) {
-            request.SetHeader(headerKey, headerValue);
+        const char* colon = scan::FindChar(lineStart, lineEnd, ':');
+        if (colon != lineEnd) {
+            if (colon == lineStart || scan::FindNonToken(lineStart, colon) != colon) {
+                throw std::invalid_argument("Invalid header name");
+            }
+
+            const char* valueStart = colon + 1;
+            const char* valueEnd = lineEnd;
+            scan::TrimWhitespace(valueStart, valueEnd);
+            if (scan::FindNonFieldValue(valueStart, valueEnd) != valueEnd) {
+                throw std::invalid_argument("Invalid header value");
+            }
+            request.SetHeader(StringView(lineStart, colon - lineStart), StringView(valueStart, valueEnd - valueStart));
         }
+        lineStart = lineEnd + 2;
     }
 
-    request.SetContent(messageBody);
+    // Truncated header blocks are ignored together with any body
+    if (headersComplete) {
+        request.SetContent(StringView(lineStart, end - lineStart));
+    } else {
+        request.ClearHeaders();
+        request.ClearContent();
+    }
     return request;
 }
+
+template <>
+HttpRequest FromString<HttpRequest>(const std::string& requestString) {
+    return FromString<HttpRequest>(requestString.data(), requestString.length());
+}
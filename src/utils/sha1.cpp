@@ -0,0 +1,85 @@
+#include <cstring>
+
+#include "../../include/utils/sha1.h"
+
+namespace httpserver {
+
+    namespace {
+        std::uint32_t Rotate(std::uint32_t value, int bits) {
+            return (value << bits) | (value >> (32 - bits));
+        }
+
+        void ProcessBlock(std::uint32_t state[5], const std::uint8_t block[64]) {
+            std::uint32_t w[80];
+            for (int i = 0; i < 16; ++i) {
+                w[i] = (std::uint32_t(block[i * 4]) << 24) | (std::uint32_t(block[i * 4 + 1]) << 16) |
+                       (std::uint32_t(block[i * 4 + 2]) << 8) | std::uint32_t(block[i * 4 + 3]);
+            }
+            for (int i = 16; i < 80; ++i) {
+                w[i] = Rotate(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+            }
+
+            std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+            for (int i = 0; i < 80; ++i) {
+                std::uint32_t f, k;
+                if (i < 20) {
+                    f = (b & c) | (~b & d);
+                    k = 0x5A827999;
+                } else if (i < 40) {
+                    f = b ^ c ^ d;
+                    k = 0x6ED9EBA1;
+                } else if (i < 60) {
+                    f = (b & c) | (b & d) | (c & d);
+                    k = 0x8F1BBCDC;
+                } else {
+                    f = b ^ c ^ d;
+                    k = 0xCA62C1D6;
+                }
+                std::uint32_t temp = Rotate(a, 5) + f + e + k + w[i];
+                e = d;
+                d = c;
+                c = Rotate(b, 30);
+                b = a;
+                a = temp;
+            }
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+        }
+    }
+
+    void Sha1(const void* data, size_t length, std::uint8_t digest[SHA1_DIGEST_SIZE]) {
+        std::uint32_t state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+        const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+
+        size_t offset = 0;
+        for (; offset + 64 <= length; offset += 64) {
+            ProcessBlock(state, bytes + offset);
+        }
+
+        // Final block(s): remaining bytes, 0x80, zero padding and the bit length
+        std::uint8_t tail[128] = {};
+        size_t remaining = length - offset;
+        std::memcpy(tail, bytes + offset, remaining);
+        tail[remaining] = 0x80;
+        size_t tailLength = remaining + 9 <= 64 ? 64 : 128;
+        std::uint64_t bitLength = static_cast<std::uint64_t>(length) * 8;
+        for (int i = 0; i < 8; ++i) {
+            tail[tailLength - 1 - i] = static_cast<std::uint8_t>(bitLength >> (i * 8));
+        }
+        ProcessBlock(state, tail);
+        if (tailLength == 128) {
+            ProcessBlock(state, tail + 64);
+        }
+
+        for (int i = 0; i < 5; ++i) {
+            digest[i * 4] = static_cast<std::uint8_t>(state[i] >> 24);
+            digest[i * 4 + 1] = static_cast<std::uint8_t>(state[i] >> 16);
+            digest[i * 4 + 2] = static_cast<std::uint8_t>(state[i] >> 8);
+            digest[i * 4 + 3] = static_cast<std::uint8_t>(state[i]);
+        }
+    }
+
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdio>
+
+// Minimal assertion for the test executables, reports the failing expression and keeps going
+static int gFailures = 0;
+
+#define CHECK(expression)                                                                        \
+    do {                                                                                         \
+        if (!(expression)) {                                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #expression);  \
+            ++gFailures;                                                                         \
+        }                                                                                        \
+    } while (0)
+
+inline int Finish(const char* name) {
+    std::printf("%s: %s\n", name, gFailures ? "FAILED" : "ok");
+    return gFailures ? 1 : 0;
+}
\ No newline at end of file
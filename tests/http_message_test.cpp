@@ -0,0 +1,29 @@
+#include <string>
+
+#include "../include/http/http_message.h"
+#include "../include/utils/serialize.h"
+#include "check.h"
+
+using httpserver::HttpRequest;
+using httpserver::StringView;
+
+namespace {
+    // Proxies and HTTP/2 gateways send lowercase names, configured names are usually capitalized
+    void TestFindHeaderIgnoreCase() {
+        HttpRequest request = FromString<HttpRequest>(
+            "GET / HTTP/1.1\r\nHost: example.com\r\nx-api-key: tenant-7\r\nuser-agent: curl/8.5\r\n\r\n");
+        StringView value;
+        CHECK(!request.FindHeader("X-Api-Key", &value));
+        CHECK(request.FindHeaderIgnoreCase("X-Api-Key", &value) && value == "tenant-7");
+        CHECK(request.FindHeaderIgnoreCase("User-Agent", &value) && value == "curl/8.5");
+        CHECK(request.FindHeaderIgnoreCase("HOST", &value) && value == "example.com");
+        CHECK(request.FindHeaderIgnoreCase("Host", nullptr));
+        CHECK(!request.FindHeaderIgnoreCase("X-Api-Keys", nullptr));
+        CHECK(!request.FindHeaderIgnoreCase("Referer", &value));
+    }
+}
+
+int main() {
+    TestFindHeaderIgnoreCase();
+    return Finish("http_message_test");
+}
\ No newline at end of file
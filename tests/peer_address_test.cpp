@@ -0,0 +1,69 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <cstring>
+#include <string>
+
+#include "../include/http/peer_address.h"
+#include "../include/http/rate_limiter.h"
+#include "check.h"
+
+using httpserver::PeerAddress;
+using httpserver::RateLimitConfig;
+using httpserver::RateLimiter;
+
+namespace {
+    PeerAddress FromIpv4(const char* text, std::uint16_t port) {
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        inet_pton(AF_INET, text, &address.sin_addr);
+        return PeerAddress::FromSockaddr(reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    }
+
+    PeerAddress FromIpv6(const char* text, std::uint16_t port) {
+        sockaddr_in6 address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin6_family = AF_INET6;
+        address.sin6_port = htons(port);
+        inet_pton(AF_INET6, text, &address.sin6_addr);
+        return PeerAddress::FromSockaddr(reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    }
+
+    std::string Format(const PeerAddress& peer) {
+        char buffer[64];
+        size_t length = peer.Format(buffer, sizeof(buffer));
+        return std::string(buffer, length);
+    }
+
+    // A dual-stack listener reports IPv4 clients as ::ffff:a.b.c.d
+    void TestMappedAddress() {
+        PeerAddress plain = FromIpv4("203.0.113.7", 4000);
+        PeerAddress mapped = FromIpv6("::ffff:203.0.113.7", 4000);
+        CHECK(mapped.family == AF_INET);
+        CHECK(mapped.port == 4000);
+        CHECK(std::memcmp(mapped.address, plain.address, 4) == 0);
+        CHECK(Format(mapped) == "203.0.113.7");
+
+        PeerAddress native = FromIpv6("2001:db8::1", 4000);
+        CHECK(native.family == AF_INET6);
+        CHECK(Format(native) == "2001:db8::1");
+    }
+
+    // Mapped clients get their own bucket instead of sharing the ::ffff:0:0/64 prefix
+    void TestMappedRateLimitKey() {
+        RateLimiter limiter(RateLimitConfig(10.0, 10.0));
+        std::uint64_t plain = limiter.KeyFor(FromIpv4("203.0.113.7", 1));
+        std::uint64_t mapped = limiter.KeyFor(FromIpv6("::ffff:203.0.113.7", 2));
+        std::uint64_t other = limiter.KeyFor(FromIpv6("::ffff:198.51.100.9", 3));
+        CHECK(plain == mapped);
+        CHECK(mapped != other);
+    }
+}
+
+int main() {
+    TestMappedAddress();
+    TestMappedRateLimitKey();
+    return Finish("peer_address_test");
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include <string>
+
+#include "../include/http/uri_view.h"
+#include "check.h"
+
+using httpserver::StringView;
+using httpserver::URIView;
+
+namespace {
+    std::string NormalizedPath(const char* target) {
+        URIView view(target, std::char_traits<char>::length(target));
+        return view.GetPath().ToString();
+    }
+
+    void TestDotSegments() {
+        CHECK(NormalizedPath("/a/./b/../c") == "/a/c");
+        CHECK(NormalizedPath("/a/b/..") == "/a/");
+        CHECK(NormalizedPath("/../../etc") == "/etc");
+        CHECK(NormalizedPath("a/b") == "/a/b");
+        CHECK(NormalizedPath("") == "/");
+    }
+
+    // Encoded dots are dot segments, encoded slashes are not segment separators
+    void TestEncodedTraversal() {
+        CHECK(NormalizedPath("/a/..%2F..%2Fdebug%2Fworkers") == "/a/..%2F..%2Fdebug%2Fworkers");
+        CHECK(NormalizedPath("/static/..%2f..%2fsecret") == "/static/..%2F..%2Fsecret");
+        CHECK(NormalizedPath("/a/%2e%2e/b") == "/b");
+        CHECK(NormalizedPath("/a/b/%2E%2e/%2e/c") == "/a/c");
+        CHECK(NormalizedPath("/%2e%2e/%2e%2e/debug/workers") == "/debug/workers");
+        CHECK(NormalizedPath("/a%2Fb") == "/a%2Fb");
+        CHECK(NormalizedPath("/caf%C3%A9/x%20y") == "/caf\xC3\xA9/x y");
+    }
+
+    // Offsets past 64 KiB must not wrap
+    void TestLongQuery() {
+        std::string target = "/search?first=1&big=" + std::string(70000, 'x') + "&after=2&tail=3";
+        URIView view(target.data(), target.length());
+        StringView value;
+        CHECK(view.FindQueryParam("big", &value) && value.Length() == 70000);
+        CHECK(view.GetQueryParam("first") == "1");
+        CHECK(view.GetQueryParam("after") == "2");
+        CHECK(view.GetQueryParam("tail") == "3");
+        CHECK(!view.HasQueryParam("missing"));
+        CHECK(view.GetQueryParamCount() == 4);
+    }
+}
+
+int main() {
+    TestDotSegments();
+    TestEncodedTraversal();
+    TestLongQuery();
+    return Finish("uri_view_test");
+}
\ No newline at end of file